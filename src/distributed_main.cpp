@@ -0,0 +1,198 @@
+// Распределенный режим: мир делится на вертикальные полосы, по процессу
+// на полосу; процессы одной машины связаны Unix-сокетами.
+// Пример: flocking_distributed --domains 4 --agents 100000 --steps 500
+#include "domain.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// std::stoul молча превращает "-1" в максимум unsigned long, а "12abc" - в 12
+unsigned long parse_unsigned(const std::string& text) {
+    size_t used = 0;
+    unsigned long value = std::stoul(text, &used);
+    if (text.find('-') != std::string::npos || used != text.size()) throw std::invalid_argument(text);
+    return value;
+}
+
+struct RunOptions {
+    int domains = 4;
+    size_t agents = 10000;
+    int steps = 500;
+    double delta_time = 0.02;
+    int report_interval = 50;
+    unsigned seed = 1;
+};
+
+int run_domain(int rank, const UnixSocketTransport::Mesh& mesh, const RunOptions& options) {
+    UnixSocketTransport transport(rank, mesh);
+
+    // Потоки машины делятся между процессами-доменами
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency() / options.domains);
+    TaskScheduler scheduler(threads);
+
+    // Все процессы порождают одну и ту же стаю и оставляют себе свою полосу;
+    // начальные границы - квантили по x, чтобы домены были равно загружены
+    FlockSimulation::Parameters params;
+    std::vector<Agent> all_agents;
+    double world_bound = 0.0;
+    {
+        TaskScheduler serial(1);
+        FlockSimulation generator(params, options.agents, options.seed, &serial);
+        all_agents = generator.get_agents();
+        world_bound = generator.get_world_bound();
+    }
+
+    std::vector<double> xs;
+    for (const auto& agent : all_agents) {
+        xs.push_back(agent.position.x);
+    }
+    std::sort(xs.begin(), xs.end());
+
+    auto quantile = [&](int index) {
+        if (index <= 0) return -std::numeric_limits<double>::infinity();
+        if (index >= options.domains) return std::numeric_limits<double>::infinity();
+        return xs.empty() ? 0.0 : xs[xs.size() * index / options.domains];
+    };
+    double lower = quantile(rank);
+    double upper = quantile(rank + 1);
+
+    FlockSimulation simulation(params, 0, options.seed, &scheduler);
+    simulation.set_verbose(false);
+    simulation.set_world_bound(world_bound);
+    simulation.set_target(Vector2(0, 0));
+
+    std::vector<Agent> own_agents;
+    for (const auto& agent : all_agents) {
+        if (agent.position.x >= lower && agent.position.x < upper) own_agents.push_back(agent);
+    }
+    simulation.add_agents(own_agents);
+    all_agents.clear();
+    all_agents.shrink_to_fit();
+
+    DomainNode node(transport, simulation, lower, upper);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int step = 1; step <= options.steps; ++step) {
+        if (!node.step(options.delta_time)) {
+            std::cerr << "Domain " << rank << ": transport failure at step " << step << std::endl;
+            return 1;
+        }
+
+        if (step % options.report_interval != 0 && step != options.steps) continue;
+
+        std::vector<DomainStats> stats;
+        if (!node.gather_stats(stats)) {
+            std::cerr << "Domain " << rank << ": failed to gather stats" << std::endl;
+            return 1;
+        }
+        if (rank != 0) continue;
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t total = 0;
+        std::cout << "step " << step << " (" << std::fixed << std::setprecision(2)
+                  << 1000.0 * elapsed / step << " ms/step)" << std::endl;
+        for (size_t d = 0; d < stats.size(); ++d) {
+            total += stats[d].agent_count;
+            std::cout << "  domain " << d << " [" << stats[d].lower << ", " << stats[d].upper << ")"
+                      << " agents=" << stats[d].agent_count
+                      << " ghosts=" << stats[d].ghost_count
+                      << " migrated=" << stats[d].migrated << std::endl;
+        }
+        std::cout << "  total agents=" << total << std::endl;
+    }
+
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    RunOptions options;
+
+    // Нечисловое или отрицательное значение - как неизвестный аргумент
+    const char* current = "";
+    bool valid = true;
+    try {
+        for (int i = 1; i < argc && valid; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            current = argv[i];
+
+            if (arg == "--domains" && has_value) {
+                options.domains = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--agents" && has_value) {
+                options.agents = parse_unsigned(argv[++i]);
+            } else if (arg == "--steps" && has_value) {
+                options.steps = std::stoi(argv[++i]);
+            } else if (arg == "--dt" && has_value) {
+                options.delta_time = std::stod(argv[++i]);
+            } else if (arg == "--report" && has_value) {
+                options.report_interval = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--seed" && has_value) {
+                options.seed = static_cast<unsigned>(parse_unsigned(argv[++i]));
+            } else {
+                valid = false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid value for " << current << std::endl;
+        valid = false;
+    }
+    if (!valid) {
+        std::cerr << "Usage: " << argv[0] << " [--domains N] [--agents N] [--steps N] [--dt DT]"
+                  << " [--report N] [--seed N]" << std::endl;
+        return -1;
+    }
+
+#ifdef _WIN32
+    std::cerr << "Distributed mode requires a POSIX system" << std::endl;
+    return -1;
+#else
+    UnixSocketTransport::Mesh mesh;
+    if (!UnixSocketTransport::create_mesh(options.domains, mesh)) return -1;
+
+    std::cout << "Starting " << options.domains << " domain processes for " << options.agents << " agents" << std::endl;
+
+    std::vector<pid_t> children;
+    for (int rank = 0; rank < options.domains; ++rank) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork failed" << std::endl;
+            return -1;
+        }
+        if (pid == 0) {
+            std::cout.flush();
+            _exit(run_domain(rank, mesh, options));
+        }
+        children.push_back(pid);
+    }
+
+    // Родитель не участвует в обмене
+    for (int fd : mesh.fds) {
+        if (fd >= 0) close(fd);
+    }
+
+    int failures = 0;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failures++;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " domain processes failed" << std::endl;
+        return 1;
+    }
+    return 0;
+#endif
+}
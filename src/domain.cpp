@@ -0,0 +1,150 @@
+#include "domain.h"
+#include <limits>
+
+namespace {
+
+// Сведения о домене, которыми соседи обмениваются при перебалансировке
+struct BoundaryInfo {
+    uint64_t agent_count;
+    double lower;
+    double upper;
+};
+
+// Новая граница между левым и правым доменами. Обе стороны вычисляют ее
+// по одинаковым данным и получают одно и то же значение. Граница сдвигается
+// в сторону более загруженного домена не более чем на max_shift, а ширина
+// каждого домена остается не меньше min_width даже при одновременном
+// сдвиге его второй границы.
+double balanced_boundary(double boundary, const BoundaryInfo& left, const BoundaryInfo& right,
+                         double max_shift, double min_width) {
+    uint64_t total = left.agent_count + right.agent_count;
+    if (total == 0) return boundary;
+
+    double imbalance = (static_cast<double>(left.agent_count) - static_cast<double>(right.agent_count)) / total;
+    double moved = boundary - imbalance * max_shift;
+
+    double lowest = left.lower + min_width + max_shift;
+    double highest = right.upper - min_width - max_shift;
+    if (lowest > highest) return boundary;
+
+    return std::min(highest, std::max(lowest, moved));
+}
+
+} // namespace
+
+DomainNode::DomainNode(Transport& transport, FlockSimulation& simulation, double lower, double upper,
+                       const DomainConfig& config)
+    : transport(transport), simulation(simulation), lower(lower), upper(upper), config(config) {
+    // Гало совпадает с ячейкой сетки симуляции: α-соседи и β-агенты соседей
+    // (радиусы - наибольшие по группам)
+    halo = std::max(simulation.get_interaction_range(), 2.0 * simulation.get_obstacle_range());
+    if (this->config.max_shift <= 0.0) this->config.max_shift = halo;
+}
+
+bool DomainNode::step(double delta_time) {
+    if (!exchange_halo()) return false;
+
+    simulation.step(delta_time);
+    steps++;
+
+    // Границы сдвигаются до миграции: к следующему обмену гало каждый
+    // домен владеет только агентами внутри своей полосы
+    if (config.balance_interval > 0 && steps % config.balance_interval == 0) {
+        if (!rebalance()) return false;
+    }
+    return migrate();
+}
+
+bool DomainNode::exchange_halo() {
+    std::vector<Agent> ghosts;
+    std::vector<Agent> received;
+    double lower_edge = lower, upper_edge = upper, width = halo;
+
+    if (left() >= 0) {
+        std::vector<Agent> outgoing = simulation.copy_agents([lower_edge, width](const Agent& agent) {
+            return agent.position.x < lower_edge + width;
+        });
+        if (!transport.exchange_vector(left(), outgoing, received)) return false;
+        ghosts.insert(ghosts.end(), received.begin(), received.end());
+    }
+    if (right() >= 0) {
+        std::vector<Agent> outgoing = simulation.copy_agents([upper_edge, width](const Agent& agent) {
+            return agent.position.x >= upper_edge - width;
+        });
+        if (!transport.exchange_vector(right(), outgoing, received)) return false;
+        ghosts.insert(ghosts.end(), received.begin(), received.end());
+    }
+
+    last_ghosts = ghosts.size();
+    simulation.set_ghost_agents(std::move(ghosts));
+    return true;
+}
+
+bool DomainNode::migrate() {
+    std::vector<Agent> arrived;
+    std::vector<Agent> received;
+    double lower_edge = lower, upper_edge = upper;
+    last_migrated = 0;
+
+    // Агент за одну границу уходит к соседу; если он перелетел и соседа,
+    // тот передаст его дальше на следующем шаге
+    if (left() >= 0) {
+        std::vector<Agent> outgoing = simulation.extract_agents([lower_edge](const Agent& agent) {
+            return agent.position.x < lower_edge;
+        });
+        last_migrated += outgoing.size();
+        if (!transport.exchange_vector(left(), outgoing, received)) return false;
+        arrived.insert(arrived.end(), received.begin(), received.end());
+    }
+    if (right() >= 0) {
+        std::vector<Agent> outgoing = simulation.extract_agents([upper_edge](const Agent& agent) {
+            return agent.position.x >= upper_edge;
+        });
+        last_migrated += outgoing.size();
+        if (!transport.exchange_vector(right(), outgoing, received)) return false;
+        arrived.insert(arrived.end(), received.begin(), received.end());
+    }
+
+    if (!arrived.empty()) simulation.add_agents(arrived);
+    return true;
+}
+
+bool DomainNode::rebalance() {
+    BoundaryInfo own{simulation.get_agent_count(), lower, upper};
+    double min_width = 2.0 * halo;
+
+    std::vector<BoundaryInfo> outgoing{own};
+    std::vector<BoundaryInfo> received;
+
+    if (left() >= 0) {
+        if (!transport.exchange_vector(left(), outgoing, received) || received.size() != 1) return false;
+        lower = balanced_boundary(lower, received[0], own, config.max_shift, min_width);
+    }
+    if (right() >= 0) {
+        if (!transport.exchange_vector(right(), outgoing, received) || received.size() != 1) return false;
+        upper = balanced_boundary(upper, own, received[0], config.max_shift, min_width);
+    }
+    return true;
+}
+
+bool DomainNode::gather_stats(std::vector<DomainStats>& stats) {
+    DomainStats own;
+    own.agent_count = simulation.get_agent_count();
+    own.ghost_count = last_ghosts;
+    own.migrated = last_migrated;
+    own.lower = lower;
+    own.upper = upper;
+
+    if (transport.rank() != 0) {
+        return transport.send(0, &own, sizeof(own));
+    }
+
+    stats.assign(transport.size(), DomainStats());
+    stats[0] = own;
+    std::vector<char> buffer;
+    for (int peer = 1; peer < transport.size(); ++peer) {
+        if (!transport.receive(peer, buffer) || buffer.size() != sizeof(DomainStats)) return false;
+        std::memcpy(&stats[peer], buffer.data(), sizeof(DomainStats));
+    }
+    return true;
+}
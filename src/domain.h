@@ -0,0 +1,53 @@
+#pragma once
+#include "simulation.h"
+#include "transport.h"
+
+// Настройки пространственной декомпозиции
+struct DomainConfig {
+    int balance_interval = 20;  // шагов между перебалансировками границ
+    double max_shift = 0.0;     // предельный сдвиг границы за раз (0 - ширина гало)
+};
+
+// Состояние домена для сводки на ранге 0
+struct DomainStats {
+    uint64_t agent_count = 0;
+    uint64_t ghost_count = 0;
+    uint64_t migrated = 0; // агентов отправлено соседям за последний шаг
+    double lower = 0.0;
+    double upper = 0.0;
+};
+
+// Полоса мира lower <= x < upper, обслуживаемая одним процессом.
+// Домены упорядочены по рангу слева направо; крайние полосы открыты наружу.
+// Перед шагом соседи обмениваются агентами из полосы гало (призраками),
+// после шага агенты, пересекшие границу, передаются соседу.
+class DomainNode {
+public:
+    DomainNode(Transport& transport, FlockSimulation& simulation, double lower, double upper,
+               const DomainConfig& config = DomainConfig());
+
+    bool step(double delta_time);
+
+    // Сводка по всем доменам; заполняется только на ранге 0
+    bool gather_stats(std::vector<DomainStats>& stats);
+
+    double get_lower() const { return lower; }
+    double get_upper() const { return upper; }
+
+private:
+    Transport& transport;
+    FlockSimulation& simulation;
+    double lower, upper;
+    DomainConfig config;
+    double halo;     // ширина полосы призраков
+    int steps = 0;
+    uint64_t last_ghosts = 0;
+    uint64_t last_migrated = 0;
+
+    int left() const { return transport.rank() > 0 ? transport.rank() - 1 : -1; }
+    int right() const { return transport.rank() + 1 < transport.size() ? transport.rank() + 1 : -1; }
+
+    bool exchange_halo();
+    bool migrate();
+    bool rebalance();
+};
@@ -0,0 +1,112 @@
+#include "ensemble.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+EnsembleRunner::EnsembleRunner(TaskScheduler& scheduler) : scheduler(scheduler) {}
+
+size_t EnsembleRunner::add_member(const EnsembleMember& member) {
+    members.push_back(member);
+    return members.size() - 1;
+}
+
+std::vector<EnsembleSummary> EnsembleRunner::run(const EnsembleConfig& config) {
+    std::vector<EnsembleSummary> summaries(members.size());
+
+    // Пакеты из экземпляров одного размера: одинаковые размеры буферов
+    // и одинаковый объем работы на шаг у всех экземпляров пакета
+    std::map<size_t, std::vector<size_t>> by_size;
+    for (size_t i = 0; i < members.size(); ++i) {
+        by_size[members[i].agent_count].push_back(i);
+    }
+
+    std::vector<std::vector<size_t>> batches;
+    size_t batch_size = std::max<size_t>(1, config.batch_size);
+    for (const auto& group : by_size) {
+        const std::vector<size_t>& indices = group.second;
+        for (size_t begin = 0; begin < indices.size(); begin += batch_size) {
+            size_t end = std::min(indices.size(), begin + batch_size);
+            batches.emplace_back(indices.begin() + begin, indices.begin() + end);
+        }
+    }
+
+    TaskGraph graph;
+    for (const auto& batch : batches) {
+        graph.add_task([this, &batch, &config, &summaries] { run_batch(batch, config, summaries); });
+    }
+    scheduler.run(graph);
+
+    return summaries;
+}
+
+void EnsembleRunner::run_batch(const std::vector<size_t>& batch, const EnsembleConfig& config,
+                               std::vector<EnsembleSummary>& summaries) {
+    // Экземпляры живут только пока выполняется пакет
+    std::vector<std::unique_ptr<FlockSimulation>> simulations;
+    for (size_t index : batch) {
+        const EnsembleMember& member = members[index];
+        simulations.push_back(std::make_unique<FlockSimulation>(member.params, member.agent_count, member.seed, &serial));
+
+        FlockSimulation& simulation = *simulations.back();
+        simulation.set_verbose(false);
+        
+        // Замеры берутся из метрик шага, временной ряд не нужен
+        MetricsConfig metrics_config;
+        metrics_config.enabled = true;
+        metrics_config.history_limit = 1;
+        metrics_config.collision_distance = config.collision_distance;
+        simulation.set_metrics_config(metrics_config);
+        
+        if (member.use_target) {
+            simulation.set_target(member.target);
+        } else {
+            simulation.remove_target();
+        }
+
+        EnsembleSummary& summary = summaries[index];
+        summary.index = index;
+        summary.seed = member.seed;
+        summary.agent_count = member.agent_count;
+    }
+
+    int steps = static_cast<int>(std::ceil(config.duration / config.delta_time));
+    int interval = std::max(1, config.metric_interval);
+
+    // Экземпляры пакета идут в ногу, чтобы один и тот же код шага оставался горячим;
+    // между замерами каждый делает пакет шагов step_n
+    for (int step = 0; step < steps;) {
+        int count = std::min(interval - step % interval, steps - step);
+        step += count;
+        bool last = step == steps;
+
+        for (size_t k = 0; k < simulations.size(); ++k) {
+            FlockSimulation& simulation = *simulations[k];
+            simulation.step_n(count, config.delta_time);
+
+            EnsembleSummary& summary = summaries[batch[k]];
+            FlockMetrics metrics = simulation.get_metrics();
+            summary.collisions += metrics.collisions;
+            summary.velocity_mismatch = metrics.velocity_mismatch;
+            if (summary.convergence_time < 0 && metrics.velocity_mismatch < config.convergence_tolerance) {
+                summary.convergence_time = metrics.time;
+            }
+            if (last) summary.fragments = static_cast<int>(metrics.components);
+        }
+    }
+}
+
+void EnsembleRunner::write_summary(std::ostream& out, const std::vector<EnsembleSummary>& summaries) const {
+    out << "index,seed,agents,desired_distance,interaction_range,c1_alpha,c2_alpha,c1_gamma,c2_gamma,"
+           "epsilon,h_alpha,convergence_time,fragments,collisions,velocity_mismatch\n";
+
+    for (const auto& summary : summaries) {
+        const FlockSimulation::Parameters& params = members[summary.index].params;
+        out << summary.index << ',' << summary.seed << ',' << summary.agent_count << ','
+            << params.desired_distance << ',' << params.interaction_range << ','
+            << params.c1_alpha << ',' << params.c2_alpha << ','
+            << params.c1_gamma << ',' << params.c2_gamma << ','
+            << params.epsilon << ',' << params.h_alpha << ','
+            << summary.convergence_time << ',' << summary.fragments << ','
+            << summary.collisions << ',' << summary.velocity_mismatch << '\n';
+    }
+}
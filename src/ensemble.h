@@ -0,0 +1,57 @@
+#pragma once
+#include "simulation.h"
+#include <ostream>
+
+// Участник ансамбля: независимая симуляция со своими параметрами и зерном
+struct EnsembleMember {
+    FlockSimulation::Parameters params;
+    size_t agent_count = 200;
+    unsigned seed = 0;
+    bool use_target = true;
+    Vector2 target;
+};
+
+// Настройки прогона ансамбля
+struct EnsembleConfig {
+    double duration = 30.0;             // модельное время одного прогона, с
+    double delta_time = 0.02;
+    int metric_interval = 10;           // шагов между замерами метрик
+    double convergence_tolerance = 0.5; // порог СКО скоростей от средней
+    double collision_distance = 1.0;    // пары ближе считаются столкновением
+    size_t batch_size = 8;              // экземпляров одного размера в задаче
+};
+
+// Краткий итог одного прогона
+struct EnsembleSummary {
+    size_t index = 0;
+    unsigned seed = 0;
+    size_t agent_count = 0;
+    double convergence_time = -1.0; // -1: скорости так и не согласовались
+    int fragments = 0;              // компоненты связности графа близости в конце
+    size_t collisions = 0;          // столкновения, суммарно по замерам
+    double velocity_mismatch = 0.0; // СКО скоростей от средней в конце
+};
+
+// Запуск множества небольших симуляций в одном процессе. Экземпляры
+// одинакового размера группируются в пакеты; пакет - задача общего
+// планировщика, внутри пакета экземпляры шагают последовательно.
+class EnsembleRunner {
+public:
+    explicit EnsembleRunner(TaskScheduler& scheduler = TaskScheduler::shared());
+
+    size_t add_member(const EnsembleMember& member);
+    size_t size() const { return members.size(); }
+
+    std::vector<EnsembleSummary> run(const EnsembleConfig& config);
+
+    // CSV: параметры экземпляра и его итог, по строке на экземпляр
+    void write_summary(std::ostream& out, const std::vector<EnsembleSummary>& summaries) const;
+
+private:
+    TaskScheduler& scheduler;
+    TaskScheduler serial{1}; // шаги внутри экземпляра выполняются без потоков
+    std::vector<EnsembleMember> members;
+
+    void run_batch(const std::vector<size_t>& batch, const EnsembleConfig& config,
+                   std::vector<EnsembleSummary>& summaries);
+};
@@ -0,0 +1,177 @@
+// Ансамбль независимых симуляций для исследования параметров.
+// Пример: flocking_ensemble --agents 200 --seeds 10 --vary c1_alpha=4:12:5 --out summary.csv
+#include "ensemble.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// std::stoul молча превращает "-1" в максимум unsigned long, а "12abc" - в 12
+unsigned long parse_unsigned(const std::string& text) {
+    size_t used = 0;
+    unsigned long value = std::stoul(text, &used);
+    if (text.find('-') != std::string::npos || used != text.size()) throw std::invalid_argument(text);
+    return value;
+}
+
+// Варьируемые параметры по имени
+struct ParameterField {
+    const char* name;
+    double FlockSimulation::Parameters::* field;
+};
+
+const ParameterField parameter_fields[] = {
+    {"desired_distance", &FlockSimulation::Parameters::desired_distance},
+    {"interaction_range", &FlockSimulation::Parameters::interaction_range},
+    {"obstacle_range", &FlockSimulation::Parameters::obstacle_range},
+    {"c1_alpha", &FlockSimulation::Parameters::c1_alpha},
+    {"c2_alpha", &FlockSimulation::Parameters::c2_alpha},
+    {"c1_beta", &FlockSimulation::Parameters::c1_beta},
+    {"c2_beta", &FlockSimulation::Parameters::c2_beta},
+    {"c1_gamma", &FlockSimulation::Parameters::c1_gamma},
+    {"c2_gamma", &FlockSimulation::Parameters::c2_gamma},
+    {"epsilon", &FlockSimulation::Parameters::epsilon},
+    {"h_alpha", &FlockSimulation::Parameters::h_alpha},
+    {"h_beta", &FlockSimulation::Parameters::h_beta},
+};
+
+// Ось сетки параметров: name=min:max:count
+struct SweepAxis {
+    double FlockSimulation::Parameters::* field = nullptr;
+    double min_value = 0.0, max_value = 0.0;
+    int count = 1;
+
+    double value(int i) const {
+        return count > 1 ? min_value + (max_value - min_value) * i / (count - 1) : min_value;
+    }
+};
+
+bool parse_axis(const std::string& spec, SweepAxis& axis) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos) return false;
+
+    std::string name = spec.substr(0, eq);
+    for (const auto& entry : parameter_fields) {
+        if (name == entry.name) axis.field = entry.field;
+    }
+    if (!axis.field) return false;
+
+    return std::sscanf(spec.c_str() + eq + 1, "%lf:%lf:%d", &axis.min_value, &axis.max_value, &axis.count) == 3 &&
+           axis.count >= 1;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--agents N] [--seeds K] [--duration T] [--dt DT]\n"
+              << "       [--threads T] [--out FILE] [--no-target] [--vary name=min:max:count]...\n"
+              << "Parameters:";
+    for (const auto& entry : parameter_fields) {
+        std::cerr << ' ' << entry.name;
+    }
+    std::cerr << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t agent_count = 200;
+    unsigned seeds = 1;
+    unsigned threads = 0;
+    bool use_target = true;
+    std::string out_path;
+    EnsembleConfig config;
+    std::vector<SweepAxis> axes;
+
+    // Нечисловое или отрицательное значение - как неизвестный аргумент
+    const char* current = "";
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            current = argv[i];
+
+            if (arg == "--agents" && has_value) {
+                agent_count = parse_unsigned(argv[++i]);
+            } else if (arg == "--seeds" && has_value) {
+                seeds = parse_unsigned(argv[++i]);
+            } else if (arg == "--duration" && has_value) {
+                config.duration = std::stod(argv[++i]);
+            } else if (arg == "--dt" && has_value) {
+                config.delta_time = std::stod(argv[++i]);
+            } else if (arg == "--threads" && has_value) {
+                threads = parse_unsigned(argv[++i]);
+            } else if (arg == "--out" && has_value) {
+                out_path = argv[++i];
+            } else if (arg == "--no-target") {
+                use_target = false;
+            } else if (arg == "--vary" && has_value) {
+                SweepAxis axis;
+                if (!parse_axis(argv[++i], axis)) {
+                    std::cerr << "Invalid sweep: " << argv[i] << std::endl;
+                    print_usage(argv[0]);
+                    return -1;
+                }
+                axes.push_back(axis);
+            } else {
+                print_usage(argv[0]);
+                return -1;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid value for " << current << std::endl;
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    TaskScheduler scheduler(threads);
+    EnsembleRunner runner(scheduler);
+
+    // Декартово произведение осей, повторенное для каждого зерна
+    size_t combinations = 1;
+    for (const auto& axis : axes) {
+        combinations *= axis.count;
+    }
+
+    for (size_t combination = 0; combination < combinations; ++combination) {
+        EnsembleMember member;
+        member.agent_count = agent_count;
+        member.use_target = use_target;
+
+        size_t rest = combination;
+        for (const auto& axis : axes) {
+            member.params.*axis.field = axis.value(static_cast<int>(rest % axis.count));
+            rest /= axis.count;
+        }
+
+        for (unsigned seed = 1; seed <= seeds; ++seed) {
+            member.seed = seed;
+            runner.add_member(member);
+        }
+    }
+
+    std::cout << "Running ensemble: " << runner.size() << " simulations x " << agent_count << " agents on "
+              << scheduler.get_thread_count() << " threads" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<EnsembleSummary> summaries = runner.run(config);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Finished in " << elapsed << " s (" << runner.size() / elapsed << " runs/s)" << std::endl;
+
+    if (out_path.empty()) {
+        runner.write_summary(std::cout, summaries);
+    } else {
+        std::ofstream out(out_path);
+        if (!out) {
+            std::cerr << "Failed to open " << out_path << std::endl;
+            return -1;
+        }
+        runner.write_summary(out, summaries);
+        std::cout << "Summary written to " << out_path << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "flock_metrics.h"
+#include <utility>
+
+void ConcurrentUnionFind::reset(size_t new_count) {
+    if (new_count > capacity) {
+        parent.reset(new std::atomic<uint32_t>[new_count]);
+        capacity = new_count;
+    }
+    count = new_count;
+    for (size_t i = 0; i < count; ++i) {
+        parent[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+    }
+}
+
+uint32_t ConcurrentUnionFind::find(uint32_t x) {
+    while (true) {
+        uint32_t p = parent[x].load(std::memory_order_relaxed);
+        if (p == x) return x;
+
+        uint32_t grandparent = parent[p].load(std::memory_order_relaxed);
+        if (grandparent != p) {
+            // Неудача CAS не страшна: кто-то уже поднял x выше
+            parent[x].compare_exchange_weak(p, grandparent, std::memory_order_relaxed);
+        }
+        x = grandparent;
+    }
+}
+
+void ConcurrentUnionFind::unite(uint32_t a, uint32_t b) {
+    while (true) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+
+        // a все еще корень - подвешиваем; иначе его успели подвесить, повторяем
+        uint32_t expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
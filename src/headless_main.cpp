@@ -0,0 +1,145 @@
+// Рендеринг прогона в видеопоток без окна и GPU.
+// Пример: flocking_headless --agents 100000 --steps 600 --format y4m --out run.y4m
+//         flocking_headless --format ppm --out - | ffmpeg -f image2pipe -i - run.mp4
+#include "offscreen_renderer.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// std::stoul молча превращает "-1" в максимум unsigned long, а "12abc" - в 12
+unsigned long parse_unsigned(const std::string& text) {
+    size_t used = 0;
+    unsigned long value = std::stoul(text, &used);
+    if (text.find('-') != std::string::npos || used != text.size()) throw std::invalid_argument(text);
+    return value;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t agent_count = 1000;
+    int steps = 600;
+    int render_every = 1;
+    int width = 1000, height = 800;
+    int fps = 60;
+    unsigned seed = 1;
+    double delta_time = 1.0 / 60.0;
+    bool show_betas = false, show_connections = false;
+    FrameFormat format = FrameFormat::Y4M;
+    std::string out_path = "flocking.y4m";
+    std::vector<Vector2> obstacles;
+
+    // Нечисловое или отрицательное значение - как неизвестный аргумент
+    bool valid = true;
+    const char* current = "";
+    try {
+        for (int i = 1; i < argc && valid; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            current = argv[i];
+
+            if (arg == "--agents" && has_value) {
+                agent_count = parse_unsigned(argv[++i]);
+            } else if (arg == "--steps" && has_value) {
+                steps = std::stoi(argv[++i]);
+            } else if (arg == "--every" && has_value) {
+                render_every = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--size" && has_value) {
+                if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                    std::cerr << "Invalid size: " << argv[i] << std::endl;
+                    return -1;
+                }
+            } else if (arg == "--fps" && has_value) {
+                fps = std::stoi(argv[++i]);
+            } else if (arg == "--dt" && has_value) {
+                delta_time = std::stod(argv[++i]);
+            } else if (arg == "--seed" && has_value) {
+                seed = static_cast<unsigned>(parse_unsigned(argv[++i]));
+            } else if (arg == "--format" && has_value) {
+                std::string name = argv[++i];
+                if (name == "raw") format = FrameFormat::Raw;
+                else if (name == "ppm") format = FrameFormat::PPM;
+                else if (name == "y4m") format = FrameFormat::Y4M;
+                else {
+                    std::cerr << "Unknown format: " << name << std::endl;
+                    return -1;
+                }
+            } else if (arg == "--out" && has_value) {
+                out_path = argv[++i];
+            } else if (arg == "--obstacle" && has_value) {
+                double x = 0, y = 0;
+                if (std::sscanf(argv[++i], "%lf,%lf", &x, &y) != 2) {
+                    std::cerr << "Invalid obstacle: " << argv[i] << std::endl;
+                    return -1;
+                }
+                obstacles.emplace_back(x, y);
+            } else if (arg == "--betas") {
+                show_betas = true;
+            } else if (arg == "--connections") {
+                show_connections = true;
+            } else {
+                valid = false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid value for " << current << std::endl;
+        valid = false;
+    }
+    if (!valid) {
+        std::cerr << "Usage: " << argv[0] << " [--agents N] [--steps N] [--every N] [--size WxH] [--fps N]\n"
+                  << "       [--dt DT] [--seed N] [--format raw|ppm|y4m] [--out FILE|-]\n"
+                  << "       [--obstacle X,Y]... [--betas] [--connections]" << std::endl;
+        return -1;
+    }
+
+    // При выводе кадров в stdout сообщения идут в stderr
+    std::ostream& log = out_path == "-" ? std::cerr : std::cout;
+
+    FlockSimulation simulation(FlockSimulation::Parameters(), agent_count, seed);
+    simulation.set_verbose(false);
+    simulation.set_target(Vector2(0, 0));
+    for (const auto& position : obstacles) {
+        simulation.add_obstacle(position);
+    }
+    if (show_betas) simulation.toggle_beta_display();
+    if (show_connections) simulation.toggle_connections();
+
+    OffscreenRenderer renderer(width, height);
+    FrameWriter writer;
+    if (!writer.open(out_path, format, width, height, fps)) {
+        return -1;
+    }
+
+    log << "Rendering " << steps << " steps of " << agent_count << " agents to " << out_path
+        << " (" << width << "x" << height << ")" << std::endl;
+
+    double simulate_seconds = 0, render_seconds = 0;
+    for (int step = 0; step < steps;) {
+        // Шаги между кадрами идут одним пакетом
+        int count = std::min(render_every - step % render_every, steps - step);
+        step += count;
+
+        auto start = std::chrono::steady_clock::now();
+        simulation.step_n(count, delta_time);
+        auto simulated = std::chrono::steady_clock::now();
+        simulate_seconds += std::chrono::duration<double>(simulated - start).count();
+
+        if (step % render_every != 0) continue;
+
+        renderer.render(simulation);
+        writer.write(renderer.get_framebuffer());
+        render_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - simulated).count();
+    }
+
+    writer.close();
+    log << "Frames written: " << writer.get_frames_written()
+        << " | simulation " << 1000.0 * simulate_seconds / steps << " ms/step"
+        << " | rendering " << 1000.0 * render_seconds / std::max<size_t>(1, writer.get_frames_written()) << " ms/frame"
+        << std::endl;
+
+    return 0;
+}
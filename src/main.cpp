@@ -19,14 +19,28 @@ int get_console_width() {
 }
 
 #include "renderer.h"
+#include "shm_exporter.h"
 #include <thread>
 #include <chrono>
 #include <iostream>
 #include <iomanip>  // Добавляем для std::setw
+#include <string>
 
 // Глобальные переменные для управления режимами
 static bool adding_obstacles = false;
 static bool setting_target = true;
+static bool moving_obstacles = false; // новые препятствия получают случайную скорость
+
+// Объекты, доступные из колбэков GLFW через указатель окна
+struct AppContext {
+    FlockSimulation* simulation;
+    Renderer* renderer;
+    bool panning = false;
+    double last_cursor_x = 0.0, last_cursor_y = 0.0;
+};
+
+static const double PAN_STEP_PIXELS = 40.0;
+static const double ZOOM_STEP = 1.15;
 
 // Функция для вывода информации о состоянии симуляции
 void print_simulation_info(const FlockSimulation& simulation) {
@@ -39,6 +53,7 @@ void print_simulation_info(const FlockSimulation& simulation) {
         oss << " | Agents: " << simulation.get_agents().size();
         oss << " | Obstacles: " << simulation.get_obstacles().size();
         oss << " | Beta-agents: " << simulation.get_beta_agents().size();
+        oss << " | Fragments: " << simulation.get_metrics().components;
         oss << " | Target: " << (simulation.is_target_enabled() ? "ON" : "OFF");
         oss << " | Beta-display: " << (simulation.is_beta_display_enabled() ? "ON" : "OFF");
         oss << " | Connections: " << (simulation.is_connections_display_enabled() ? "ON" : "OFF");
@@ -58,9 +73,18 @@ void print_simulation_info(const FlockSimulation& simulation) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     std::cout << "Starting Flocking Simulation (Algorithm 3)..." << std::endl;
     
+    // Аргументы командной строки: --export-shm <имя> включает экспорт в разделяемую память
+    std::string shm_name;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--export-shm" && i + 1 < argc) {
+            shm_name = argv[++i];
+        }
+    }
+    
     // Инициализация рендерера
     Renderer renderer(1000, 800);
     if (!renderer.initialize()) {
@@ -72,19 +96,44 @@ int main() {
     FlockSimulation simulation;
     simulation.start();
     
+    // Строка состояния показывает число фрагментов стаи
+    MetricsConfig metrics_config;
+    metrics_config.enabled = true;
+    simulation.set_metrics_config(metrics_config);
+    
+    // Экспорт кадров для внешних процессов (аналитика, дашборды)
+    ShmExporter exporter;
+    if (!shm_name.empty() &&
+        exporter.open(shm_name, static_cast<uint32_t>(simulation.get_agents().size()))) {
+        simulation.set_step_observer([&exporter](const std::vector<Agent>& agents, const Vector2& target,
+                                                 bool target_enabled, double time) {
+            exporter.publish(agents, target, target_enabled, time);
+        });
+    }
+    
     // Устанавливаем начальную цель в центре
     simulation.set_target(Vector2(0, 0));
     
     // Колбэк для мыши
     glfwSetMouseButtonCallback(renderer.get_window(), [](GLFWwindow* window, int button, int action, int mods) {
+        AppContext* app = static_cast<AppContext*>(glfwGetWindowUserPointer(window));
+        if (!app) return;
+        
+        // Правая кнопка - перетаскивание вида
+        if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+            app->panning = (action == GLFW_PRESS);
+            glfwGetCursorPos(window, &app->last_cursor_x, &app->last_cursor_y);
+            return;
+        }
+        
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-            FlockSimulation* sim = static_cast<FlockSimulation*>(glfwGetWindowUserPointer(window));
+            FlockSimulation* sim = app->simulation;
             
             if (sim) {
                 double x, y;
                 glfwGetCursorPos(window, &x, &y);
                 
-                Renderer* rend = static_cast<Renderer*>(glfwGetWindowUserPointer(window));
+                Renderer* rend = app->renderer;
                 Vector2 world_pos = rend->screen_to_world(x, y);
                 
                 if (setting_target) {
@@ -92,19 +141,80 @@ int main() {
                     std::cout << "\n=== TARGET SET ===" << std::endl;
                 } else if (adding_obstacles) {
                     double radius = 10.0 + (rand() % 10); // Размер от 10 до 19
-                    sim->add_obstacle(world_pos, radius);
+                    if (moving_obstacles) {
+                        double angle = 2.0 * M_PI * (rand() % 360) / 360.0;
+                        double speed = 10.0 + (rand() % 20);
+                        sim->add_moving_obstacle(world_pos, Vector2(std::cos(angle), std::sin(angle)) * speed, radius);
+                    } else {
+                        sim->add_obstacle(world_pos, radius);
+                    }
                     std::cout << "\n=== OBSTACLE ADDED ===" << std::endl;
                 }
             }
         }
     });
     
+    // Колбэк для колеса мыши: масштаб относительно курсора
+    glfwSetScrollCallback(renderer.get_window(), [](GLFWwindow* window, double /*xoffset*/, double yoffset) {
+        AppContext* app = static_cast<AppContext*>(glfwGetWindowUserPointer(window));
+        if (!app) return;
+        
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        app->renderer->zoom_at(x, y, std::pow(ZOOM_STEP, -yoffset));
+    });
+    
+    // Колбэк для движения мыши: панорамирование при зажатой правой кнопке
+    glfwSetCursorPosCallback(renderer.get_window(), [](GLFWwindow* window, double x, double y) {
+        AppContext* app = static_cast<AppContext*>(glfwGetWindowUserPointer(window));
+        if (!app || !app->panning) return;
+        
+        app->renderer->pan_pixels(x - app->last_cursor_x, y - app->last_cursor_y);
+        app->last_cursor_x = x;
+        app->last_cursor_y = y;
+    });
+    
     // Колбэк для клавиш
     glfwSetKeyCallback(renderer.get_window(), [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+        AppContext* app = static_cast<AppContext*>(glfwGetWindowUserPointer(window));
+        if (!app) return;
+        
+        // Навигация повторяется при удержании клавиши
+        if (action == GLFW_PRESS || action == GLFW_REPEAT) {
+            Renderer* rend = app->renderer;
+            int width, height;
+            glfwGetWindowSize(window, &width, &height);
+            
+            switch (key) {
+                case GLFW_KEY_LEFT:  rend->pan_pixels(PAN_STEP_PIXELS, 0); break;
+                case GLFW_KEY_RIGHT: rend->pan_pixels(-PAN_STEP_PIXELS, 0); break;
+                case GLFW_KEY_UP:    rend->pan_pixels(0, PAN_STEP_PIXELS); break;
+                case GLFW_KEY_DOWN:  rend->pan_pixels(0, -PAN_STEP_PIXELS); break;
+                case GLFW_KEY_EQUAL:
+                case GLFW_KEY_KP_ADD:
+                    rend->zoom_at(width / 2.0, height / 2.0, 1.0 / ZOOM_STEP);
+                    break;
+                case GLFW_KEY_MINUS:
+                case GLFW_KEY_KP_SUBTRACT:
+                    rend->zoom_at(width / 2.0, height / 2.0, ZOOM_STEP);
+                    break;
+            }
+        }
+        
         if (action == GLFW_PRESS) {
-            FlockSimulation* sim = static_cast<FlockSimulation*>(glfwGetWindowUserPointer(window));
+            FlockSimulation* sim = app->simulation;
             
             switch (key) {
+                case GLFW_KEY_HOME:
+                    app->renderer->reset_camera();
+                    std::cout << "\n🔍 VIEW RESET" << std::endl;
+                    break;
+                    
+                case GLFW_KEY_L:
+                    app->renderer->toggle_density_lod();
+                    std::cout << "\n🗺  DENSITY LOD: " << (app->renderer->is_density_lod_enabled() ? "ON" : "OFF") << std::endl;
+                    break;
+                    
                 case GLFW_KEY_T:
                     setting_target = true;
                     adding_obstacles = false;
@@ -118,6 +228,11 @@ int main() {
                     std::cout << "\n🚧 MODE: Add Obstacles (click to place obstacles)" << std::endl;
                     break;
                     
+                case GLFW_KEY_M:
+                    moving_obstacles = !moving_obstacles;
+                    std::cout << "\n🚗 NEW OBSTACLES: " << (moving_obstacles ? "MOVING" : "STATIC") << std::endl;
+                    break;
+                    
                 case GLFW_KEY_C:
                     if (sim) {
                         sim->clear_obstacles();
@@ -155,10 +270,13 @@ int main() {
                     std::cout << "\n=== FLOCKING SIMULATION CONTROLS ===" << std::endl;
                     std::cout << "T - Set target mode (click to set flock target)" << std::endl;
                     std::cout << "O - Add obstacle mode (click to place obstacles)" << std::endl;
+                    std::cout << "M - Toggle moving obstacles" << std::endl;
                     std::cout << "C - Clear all obstacles" << std::endl;
                     std::cout << "B - Toggle β-agents display" << std::endl;
                     std::cout << "X - Remove target (swarm only mode)" << std::endl;
                     std::cout << "G - Toggle connections display" << std::endl; // НОВОЕ
+                    std::cout << "Wheel / +/- - Zoom, Right drag / arrows - Pan, Home - Reset view" << std::endl;
+                    std::cout << "L - Toggle density LOD when zoomed out" << std::endl;
                     std::cout << "H - Show this help" << std::endl;
                     std::cout << "ESC - Exit" << std::endl;
                     std::cout << "=====================================" << std::endl;
@@ -168,7 +286,8 @@ int main() {
     });
     
     // Сохраняем указатель для колбэков
-    glfwSetWindowUserPointer(renderer.get_window(), &simulation);
+    AppContext app{&simulation, &renderer};
+    glfwSetWindowUserPointer(renderer.get_window(), &app);
     
     // Главный цикл
     auto last_sim_time = std::chrono::steady_clock::now();
@@ -177,10 +296,13 @@ int main() {
     std::cout << "\n=== FLOCKING SIMULATION CONTROLS ===" << std::endl;
     std::cout << "T - Set target mode (click to set flock target)" << std::endl;
     std::cout << "O - Add obstacle mode (click to place obstacles)" << std::endl;
+    std::cout << "M - Toggle moving obstacles" << std::endl;
     std::cout << "C - Clear all obstacles" << std::endl;
     std::cout << "B - Toggle β-agents display" << std::endl;
     std::cout << "X - Remove target (swarm only mode)" << std::endl;
     std::cout << "G - Toggle connections display" << std::endl; // НОВОЕ
+    std::cout << "Wheel / +/- - Zoom, Right drag / arrows - Pan, Home - Reset view" << std::endl;
+    std::cout << "L - Toggle density LOD when zoomed out" << std::endl;
     std::cout << "H - Show this help" << std::endl;
     std::cout << "ESC - Exit" << std::endl;
     std::cout << "=====================================" << std::endl;
@@ -0,0 +1,483 @@
+#include "offscreen_renderer.h"
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+// Цвета совпадают с Renderer
+const float BACKGROUND[3] = {0.1f, 0.1f, 0.1f};
+const float AGENT_COLOR[4] = {0.0f, 0.7f, 1.0f, 1.0f};
+const float OBSTACLE_COLOR[4] = {0.9f, 0.2f, 0.2f, 1.0f};
+const float OBSTACLE_ARROW_COLOR[4] = {1.0f, 0.6f, 0.6f, 1.0f};
+const float BETA_COLOR[4] = {1.0f, 0.5f, 0.0f, 1.0f};
+const float TARGET_COLOR[4] = {0.2f, 0.9f, 0.2f, 1.0f};
+
+// Вид как у камеры Renderer по умолчанию: по вертикали от -200 до +200,
+// ширина следует из пропорций кадра
+const double WORLD_HALF_SIZE = 200.0;
+
+uint8_t to_byte(float value) {
+    return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value * 255.0f + 0.5f)));
+}
+
+void blend_pixel(uint8_t* pixel, const float color[4]) {
+    float a = color[3];
+    if (a >= 1.0f) {
+        pixel[0] = to_byte(color[0]);
+        pixel[1] = to_byte(color[1]);
+        pixel[2] = to_byte(color[2]);
+        return;
+    }
+    for (int c = 0; c < 3; ++c) {
+        pixel[c] = to_byte(color[c] * a + pixel[c] / 255.0f * (1.0f - a));
+    }
+}
+
+} // namespace
+
+FrameWriter::~FrameWriter() {
+    close();
+}
+
+bool FrameWriter::open(const std::string& path, FrameFormat frame_format, int frame_width, int frame_height, int fps) {
+    close();
+
+    if (path == "-") {
+        file = stdout;
+        owns_file = false;
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+        owns_file = true;
+        if (!file) {
+            std::cerr << "Failed to open " << path << " for writing" << std::endl;
+            return false;
+        }
+    }
+
+    format = frame_format;
+    width = frame_width;
+    height = frame_height;
+    frames_written = 0;
+    closing = false;
+
+    // Y4M: заголовок потока, 4:4:4 без субдискретизации цвета
+    if (format == FrameFormat::Y4M) {
+        std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+    }
+
+    worker = std::thread(&FrameWriter::worker_loop, this);
+    return true;
+}
+
+void FrameWriter::close() {
+    if (!file) return;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        closing = true;
+    }
+    queue_cv.notify_all();
+    worker.join();
+
+    std::fflush(file);
+    if (owns_file) std::fclose(file);
+    file = nullptr;
+}
+
+void FrameWriter::write(const std::vector<uint8_t>& rgb) {
+    if (!file) return;
+
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_cv.wait(lock, [this] { return pending.size() < max_pending; });
+
+    std::vector<uint8_t> buffer;
+    if (!free_buffers.empty()) {
+        buffer.swap(free_buffers.back());
+        free_buffers.pop_back();
+    }
+    buffer.assign(rgb.begin(), rgb.end());
+    pending.push_back(std::move(buffer));
+
+    lock.unlock();
+    queue_cv.notify_all();
+}
+
+void FrameWriter::worker_loop() {
+    std::vector<uint8_t> output;
+
+    while (true) {
+        std::vector<uint8_t> frame;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this] { return closing || !pending.empty(); });
+            if (pending.empty()) return; // closing и очередь пуста
+
+            frame.swap(pending.front());
+            pending.pop_front();
+        }
+        queue_cv.notify_all();
+
+        encode(frame, output);
+        std::fwrite(output.data(), 1, output.size(), file);
+        frames_written++;
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        free_buffers.push_back(std::move(frame));
+    }
+}
+
+void FrameWriter::encode(const std::vector<uint8_t>& rgb, std::vector<uint8_t>& output) const {
+    size_t pixels = static_cast<size_t>(width) * height;
+    output.clear();
+
+    switch (format) {
+        case FrameFormat::Raw:
+            output.assign(rgb.begin(), rgb.end());
+            break;
+
+        case FrameFormat::PPM: {
+            std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+            output.assign(header.begin(), header.end());
+            output.insert(output.end(), rgb.begin(), rgb.end());
+            break;
+        }
+
+        case FrameFormat::Y4M: {
+            // BT.601, полный диапазон; плоскости Y, U, V подряд
+            static const std::string marker = "FRAME\n";
+            output.insert(output.end(), marker.begin(), marker.end());
+            size_t offset = output.size();
+            output.resize(offset + 3 * pixels);
+
+            uint8_t* y_plane = output.data() + offset;
+            uint8_t* u_plane = y_plane + pixels;
+            uint8_t* v_plane = u_plane + pixels;
+            for (size_t i = 0; i < pixels; ++i) {
+                float r = rgb[3 * i], g = rgb[3 * i + 1], b = rgb[3 * i + 2];
+                y_plane[i] = static_cast<uint8_t>(std::min(255.0f, 0.299f * r + 0.587f * g + 0.114f * b + 0.5f));
+                u_plane[i] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, -0.1687f * r - 0.3313f * g + 0.5f * b + 128.5f)));
+                v_plane[i] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, 0.5f * r - 0.4187f * g - 0.0813f * b + 128.5f)));
+            }
+            break;
+        }
+    }
+}
+
+OffscreenRenderer::OffscreenRenderer(int width, int height, TaskScheduler& scheduler)
+    : width(width), height(height), scheduler(scheduler) {
+    tile_cols = (width + tile_size - 1) / tile_size;
+    tile_rows = (height + tile_size - 1) / tile_size;
+    framebuffer.resize(static_cast<size_t>(width) * height * 3);
+    tile_bins.resize(tile_cols * tile_rows);
+
+    for (int tile = 0; tile < tile_cols * tile_rows; ++tile) {
+        raster_graph.add_task([this, tile] { rasterize_tile(tile); });
+    }
+}
+
+Vector2 OffscreenRenderer::to_screen(const Vector2& world) const {
+    // Один масштаб по обеим осям, чтобы круги препятствий совпадали с β-агентами на них
+    double scale = pixels_per_unit();
+    return Vector2(0.5 * width + world.x * scale, 0.5 * height - world.y * scale);
+}
+
+float OffscreenRenderer::world_to_pixels(double length) const {
+    return static_cast<float>(length * pixels_per_unit());
+}
+
+double OffscreenRenderer::pixels_per_unit() const {
+    return height / (2.0 * view_half_height);
+}
+
+void OffscreenRenderer::render(const FlockSimulation& simulation) {
+    // Большая стая живет в расширенной области: вид охватывает ее границу
+    view_half_height = std::max(WORLD_HALF_SIZE, simulation.get_world_bound());
+
+    // Читаем состояние без копирования; шаг ждет конца рендеринга
+    auto state = simulation.view_state();
+    const auto& agents = state.agents;
+    const auto& obstacles = state.obstacles;
+    const auto& beta_agents = state.beta_agents;
+    const auto& target = state.target;
+
+    primitives.clear();
+    for (auto& bin : tile_bins) {
+        bin.clear();
+    }
+
+    // Порядок отрисовки как в Renderer::render
+    if (simulation.is_connections_display_enabled()) {
+        emit_connections(agents, beta_agents, state.interaction_range, state.obstacle_range);
+    }
+    if (simulation.is_target_enabled()) {
+        emit_target(target);
+    }
+    for (const auto& obstacle : obstacles) {
+        emit_obstacle(obstacle);
+    }
+    if (simulation.is_beta_display_enabled()) {
+        for (const auto& beta_agent : beta_agents) {
+            emit_beta_agent(beta_agent);
+        }
+    }
+    for (const auto& agent : agents) {
+        emit_agent(agent);
+    }
+
+    // Примитивы уже в пикселях: растеризация не держит симуляцию
+    state.snapshot_lock.unlock();
+    state.data_lock.unlock();
+    scheduler.run(raster_graph);
+}
+
+void OffscreenRenderer::add_triangle(const Vector2& a, const Vector2& b, const Vector2& c, const float color[4]) {
+    Vector2 sa = to_screen(a), sb = to_screen(b), sc = to_screen(c);
+    Primitive primitive{Primitive::Type::Triangle,
+                        {float(sa.x), float(sa.y), float(sb.x), float(sb.y), float(sc.x), float(sc.y)},
+                        {color[0], color[1], color[2], color[3]}};
+    primitives.push_back(primitive);
+    bin_primitive(static_cast<uint32_t>(primitives.size() - 1),
+                  std::min({primitive.v[0], primitive.v[2], primitive.v[4]}),
+                  std::min({primitive.v[1], primitive.v[3], primitive.v[5]}),
+                  std::max({primitive.v[0], primitive.v[2], primitive.v[4]}),
+                  std::max({primitive.v[1], primitive.v[3], primitive.v[5]}));
+}
+
+void OffscreenRenderer::add_circle(const Vector2& center, double radius, const float color[4]) {
+    Vector2 sc = to_screen(center);
+    float r = world_to_pixels(radius);
+    Primitive primitive{Primitive::Type::Circle, {float(sc.x), float(sc.y), r, 0, 0, 0},
+                        {color[0], color[1], color[2], color[3]}};
+    primitives.push_back(primitive);
+    bin_primitive(static_cast<uint32_t>(primitives.size() - 1), primitive.v[0] - r, primitive.v[1] - r,
+                  primitive.v[0] + r, primitive.v[1] + r);
+}
+
+void OffscreenRenderer::add_rect(const Vector2& min_corner, const Vector2& max_corner, const float color[4]) {
+    Vector2 a = to_screen(min_corner), b = to_screen(max_corner);
+    Primitive primitive{Primitive::Type::Rect,
+                        {float(std::min(a.x, b.x)), float(std::min(a.y, b.y)),
+                         float(std::max(a.x, b.x)), float(std::max(a.y, b.y)), 0, 0},
+                        {color[0], color[1], color[2], color[3]}};
+    primitives.push_back(primitive);
+    bin_primitive(static_cast<uint32_t>(primitives.size() - 1), primitive.v[0], primitive.v[1],
+                  primitive.v[2], primitive.v[3]);
+}
+
+void OffscreenRenderer::add_line(const Vector2& a, const Vector2& b, const float color[4]) {
+    Vector2 sa = to_screen(a), sb = to_screen(b);
+    Primitive primitive{Primitive::Type::Line, {float(sa.x), float(sa.y), float(sb.x), float(sb.y), 0, 0},
+                        {color[0], color[1], color[2], color[3]}};
+    primitives.push_back(primitive);
+    bin_primitive(static_cast<uint32_t>(primitives.size() - 1),
+                  std::min(primitive.v[0], primitive.v[2]) - 1, std::min(primitive.v[1], primitive.v[3]) - 1,
+                  std::max(primitive.v[0], primitive.v[2]) + 1, std::max(primitive.v[1], primitive.v[3]) + 1);
+}
+
+void OffscreenRenderer::bin_primitive(uint32_t index, float min_x, float min_y, float max_x, float max_y) {
+    if (max_x < 0 || max_y < 0 || min_x >= width || min_y >= height) return; // вне кадра
+
+    int tx0 = std::max(0, static_cast<int>(min_x) / tile_size);
+    int ty0 = std::max(0, static_cast<int>(min_y) / tile_size);
+    int tx1 = std::min(tile_cols - 1, static_cast<int>(max_x) / tile_size);
+    int ty1 = std::min(tile_rows - 1, static_cast<int>(max_y) / tile_size);
+
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            tile_bins[ty * tile_cols + tx].push_back(index);
+        }
+    }
+}
+
+void OffscreenRenderer::emit_agent(const Agent& agent) {
+    Vector2 direction = agent.velocity.length() > 0.1 ?
+                       agent.velocity.normalized() : Vector2(1, 0);
+    Vector2 perpendicular(-direction.y, direction.x);
+
+    add_triangle(agent.position + direction * 5,
+                 agent.position - direction * 3 + perpendicular * 3,
+                 agent.position - direction * 3 - perpendicular * 3, AGENT_COLOR);
+}
+
+void OffscreenRenderer::emit_obstacle(const Obstacle& obstacle) {
+    add_circle(obstacle.position, obstacle.radius, OBSTACLE_COLOR);
+
+    // Стрелка скорости для движущихся препятствий
+    if (obstacle.velocity.length() > 0.5) {
+        Vector2 dir = obstacle.velocity.normalized();
+        add_line(obstacle.position, obstacle.position + dir * (obstacle.radius + 8.0), OBSTACLE_ARROW_COLOR);
+    }
+}
+
+void OffscreenRenderer::emit_beta_agent(const BetaAgent& beta_agent) {
+    add_rect(beta_agent.position - Vector2(2, 2), beta_agent.position + Vector2(2, 2), BETA_COLOR);
+
+    if (beta_agent.velocity.length() > 0.5) {
+        Vector2 dir = beta_agent.velocity.normalized();
+        add_line(beta_agent.position, beta_agent.position + dir * 6, BETA_COLOR);
+    }
+}
+
+void OffscreenRenderer::emit_target(const Vector2& target) {
+    // Крест
+    add_line(target - Vector2(8, 0), target + Vector2(8, 0), TARGET_COLOR);
+    add_line(target - Vector2(0, 8), target + Vector2(0, 8), TARGET_COLOR);
+
+    // Круг
+    for (int i = 0; i < 16; ++i) {
+        double a0 = 2.0 * M_PI * i / 16;
+        double a1 = 2.0 * M_PI * (i + 1) / 16;
+        add_line(target + Vector2(12 * std::cos(a0), 12 * std::sin(a0)),
+                 target + Vector2(12 * std::cos(a1), 12 * std::sin(a1)), TARGET_COLOR);
+    }
+}
+
+void OffscreenRenderer::emit_connections(Span<Agent> agents, Span<BetaAgent> beta_agents,
+                                         double interaction_range, double obstacle_range) {
+    // Хеш-сетка агентов с ячейкой r: пары ищутся среди соседних ячеек
+    auto cell_id = [](int cx, int cy) { return (static_cast<long long>(cx) << 32) ^ static_cast<unsigned int>(cy); };
+    auto cell_of = [interaction_range](double v) { return static_cast<int>(std::floor(v / interaction_range)); };
+
+    std::unordered_map<long long, std::vector<uint32_t>> cells;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        cells[cell_id(cell_of(agents[i].position.x), cell_of(agents[i].position.y))].push_back(static_cast<uint32_t>(i));
+    }
+
+    // Связи между α-агентами, интенсивность зависит от расстояния
+    for (size_t i = 0; i < agents.size(); ++i) {
+        int cx = cell_of(agents[i].position.x);
+        int cy = cell_of(agents[i].position.y);
+
+        for (int ny = cy - 1; ny <= cy + 1; ++ny) {
+            for (int nx = cx - 1; nx <= cx + 1; ++nx) {
+                auto it = cells.find(cell_id(nx, ny));
+                if (it == cells.end()) continue;
+
+                for (uint32_t j : it->second) {
+                    if (j <= i) continue;
+                    double distance = (agents[j].position - agents[i].position).length();
+                    if (distance < interaction_range) {
+                        float color[4] = {1.0f, 1.0f, 1.0f, float(1.0 - distance / interaction_range / 2)};
+                        add_line(agents[i].position, agents[j].position, color);
+                    }
+                }
+            }
+        }
+    }
+
+    // Связи α-агентов с β-агентами (r' < r, достаточно соседних ячеек)
+    for (const auto& beta_agent : beta_agents) {
+        int cx = cell_of(beta_agent.position.x);
+        int cy = cell_of(beta_agent.position.y);
+
+        for (int ny = cy - 1; ny <= cy + 1; ++ny) {
+            for (int nx = cx - 1; nx <= cx + 1; ++nx) {
+                auto it = cells.find(cell_id(nx, ny));
+                if (it == cells.end()) continue;
+
+                for (uint32_t j : it->second) {
+                    double distance = (beta_agent.position - agents[j].position).length();
+                    if (distance < obstacle_range) {
+                        float color[4] = {1.0f, 0.5f, 0.0f, float(1.0 - distance / obstacle_range / 2)};
+                        add_line(agents[j].position, beta_agent.position, color);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void OffscreenRenderer::rasterize_tile(int tile) {
+    int x0 = (tile % tile_cols) * tile_size;
+    int y0 = (tile / tile_cols) * tile_size;
+    int x1 = std::min(width, x0 + tile_size);
+    int y1 = std::min(height, y0 + tile_size);
+
+    // Фон
+    uint8_t background[3] = {to_byte(BACKGROUND[0]), to_byte(BACKGROUND[1]), to_byte(BACKGROUND[2])};
+    for (int y = y0; y < y1; ++y) {
+        uint8_t* row = &framebuffer[(static_cast<size_t>(y) * width + x0) * 3];
+        for (int x = x0; x < x1; ++x, row += 3) {
+            std::memcpy(row, background, 3);
+        }
+    }
+
+    auto pixel = [this](int x, int y) { return &framebuffer[(static_cast<size_t>(y) * width + x) * 3]; };
+
+    for (uint32_t index : tile_bins[tile]) {
+        const Primitive& p = primitives[index];
+
+        switch (p.type) {
+            case Primitive::Type::Triangle: {
+                // Функции ребер; знак площади учитывает обход вершин
+                float area = (p.v[2] - p.v[0]) * (p.v[5] - p.v[1]) - (p.v[3] - p.v[1]) * (p.v[4] - p.v[0]);
+                if (std::abs(area) < 1e-6f) break;
+                float sign = area > 0 ? 1.0f : -1.0f;
+
+                int bx0 = std::max(x0, static_cast<int>(std::floor(std::min({p.v[0], p.v[2], p.v[4]}))));
+                int by0 = std::max(y0, static_cast<int>(std::floor(std::min({p.v[1], p.v[3], p.v[5]}))));
+                int bx1 = std::min(x1 - 1, static_cast<int>(std::ceil(std::max({p.v[0], p.v[2], p.v[4]}))));
+                int by1 = std::min(y1 - 1, static_cast<int>(std::ceil(std::max({p.v[1], p.v[3], p.v[5]}))));
+
+                for (int y = by0; y <= by1; ++y) {
+                    float py = y + 0.5f;
+                    for (int x = bx0; x <= bx1; ++x) {
+                        float px = x + 0.5f;
+                        float w0 = ((p.v[2] - p.v[0]) * (py - p.v[1]) - (p.v[3] - p.v[1]) * (px - p.v[0])) * sign;
+                        float w1 = ((p.v[4] - p.v[2]) * (py - p.v[3]) - (p.v[5] - p.v[3]) * (px - p.v[2])) * sign;
+                        float w2 = ((p.v[0] - p.v[4]) * (py - p.v[5]) - (p.v[1] - p.v[5]) * (px - p.v[4])) * sign;
+                        if (w0 >= 0 && w1 >= 0 && w2 >= 0) blend_pixel(pixel(x, y), p.color);
+                    }
+                }
+                break;
+            }
+
+            case Primitive::Type::Circle: {
+                float r = p.v[2];
+                int bx0 = std::max(x0, static_cast<int>(std::floor(p.v[0] - r)));
+                int by0 = std::max(y0, static_cast<int>(std::floor(p.v[1] - r)));
+                int bx1 = std::min(x1 - 1, static_cast<int>(std::ceil(p.v[0] + r)));
+                int by1 = std::min(y1 - 1, static_cast<int>(std::ceil(p.v[1] + r)));
+
+                for (int y = by0; y <= by1; ++y) {
+                    float dy = y + 0.5f - p.v[1];
+                    for (int x = bx0; x <= bx1; ++x) {
+                        float dx = x + 0.5f - p.v[0];
+                        if (dx * dx + dy * dy <= r * r) blend_pixel(pixel(x, y), p.color);
+                    }
+                }
+                break;
+            }
+
+            case Primitive::Type::Rect: {
+                int bx0 = std::max(x0, static_cast<int>(std::floor(p.v[0])));
+                int by0 = std::max(y0, static_cast<int>(std::floor(p.v[1])));
+                int bx1 = std::min(x1 - 1, static_cast<int>(std::ceil(p.v[2])) - 1);
+                int by1 = std::min(y1 - 1, static_cast<int>(std::ceil(p.v[3])) - 1);
+
+                for (int y = by0; y <= by1; ++y) {
+                    for (int x = bx0; x <= bx1; ++x) {
+                        blend_pixel(pixel(x, y), p.color);
+                    }
+                }
+                break;
+            }
+
+            case Primitive::Type::Line: {
+                // DDA по длинной оси; каждый тайл рисует только свои пиксели
+                float dx = p.v[2] - p.v[0];
+                float dy = p.v[3] - p.v[1];
+                int steps = std::max(1, static_cast<int>(std::ceil(std::max(std::abs(dx), std::abs(dy)))));
+
+                for (int s = 0; s <= steps; ++s) {
+                    float t = static_cast<float>(s) / steps;
+                    int x = static_cast<int>(std::floor(p.v[0] + dx * t));
+                    int y = static_cast<int>(std::floor(p.v[1] + dy * t));
+                    if (x >= x0 && x < x1 && y >= y0 && y < y1) blend_pixel(pixel(x, y), p.color);
+                }
+                break;
+            }
+        }
+    }
+}
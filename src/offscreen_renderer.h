@@ -0,0 +1,103 @@
+#pragma once
+#include "simulation.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <thread>
+
+// Формат потока кадров
+enum class FrameFormat { Raw, PPM, Y4M };
+
+// Асинхронная запись кадров RGB24 в файл или stdout ("-").
+// Преобразование в выходной формат и запись идут в отдельном потоке.
+class FrameWriter {
+public:
+    FrameWriter() = default;
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    bool open(const std::string& path, FrameFormat format, int width, int height, int fps = 60);
+    void close();
+    bool is_open() const { return file != nullptr; }
+
+    // Копирует кадр в очередь; блокируется, если писатель отстал на max_pending кадров
+    void write(const std::vector<uint8_t>& rgb);
+
+    size_t get_frames_written() const { return frames_written; }
+
+private:
+    FILE* file = nullptr;
+    bool owns_file = false;
+    FrameFormat format = FrameFormat::PPM;
+    int width = 0, height = 0;
+    std::atomic<size_t> frames_written{0};
+
+    static constexpr size_t max_pending = 4;
+    std::thread worker;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::vector<uint8_t>> pending;
+    std::vector<std::vector<uint8_t>> free_buffers; // переиспользуемые буферы кадров
+    bool closing = false;
+
+    void worker_loop();
+    void encode(const std::vector<uint8_t>& rgb, std::vector<uint8_t>& output) const;
+};
+
+// Программный растеризатор для рендеринга без окна и GPU.
+// Рисует то же, что Renderer, в буфер RGB24; экран разбит на тайлы,
+// примитивы раскладываются по тайлам, тайлы растеризуются параллельно.
+class OffscreenRenderer {
+public:
+    OffscreenRenderer(int width, int height, TaskScheduler& scheduler = TaskScheduler::shared());
+
+    void render(const FlockSimulation& simulation);
+
+    const std::vector<uint8_t>& get_framebuffer() const { return framebuffer; }
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+
+private:
+    // Примитив в пиксельных координатах
+    struct Primitive {
+        enum class Type { Triangle, Circle, Rect, Line };
+        Type type;
+        float v[6];     // треугольник: 3 вершины; круг: центр, радиус; прямоугольник и линия: 2 точки
+        float color[4]; // RGBA
+    };
+
+    static constexpr int tile_size = 64;
+
+    int width, height;
+    int tile_cols, tile_rows;
+    TaskScheduler& scheduler;
+    std::vector<uint8_t> framebuffer;
+    std::vector<Primitive> primitives;
+    std::vector<std::vector<uint32_t>> tile_bins; // индексы примитивов по тайлам, в порядке отрисовки
+    TaskGraph raster_graph;
+    double view_half_height = 200.0; // половина видимой высоты в мировых координатах
+
+    Vector2 to_screen(const Vector2& world) const;
+    float world_to_pixels(double length) const;
+    double pixels_per_unit() const;
+
+    void add_triangle(const Vector2& a, const Vector2& b, const Vector2& c, const float color[4]);
+    void add_circle(const Vector2& center, double radius, const float color[4]);
+    void add_rect(const Vector2& min_corner, const Vector2& max_corner, const float color[4]);
+    void add_line(const Vector2& a, const Vector2& b, const float color[4]);
+    void bin_primitive(uint32_t index, float min_x, float min_y, float max_x, float max_y);
+
+    void emit_agent(const Agent& agent);
+    void emit_obstacle(const Obstacle& obstacle);
+    void emit_beta_agent(const BetaAgent& beta_agent);
+    void emit_target(const Vector2& target);
+    void emit_connections(Span<Agent> agents, Span<BetaAgent> beta_agents,
+                          double interaction_range, double obstacle_range);
+
+    void rasterize_tile(int tile);
+};
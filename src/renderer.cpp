@@ -1,9 +1,17 @@
 #include "renderer.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+
+// LOD: ниже этого масштаба (пикселей на единицу мира) плотные области
+// рисуются тепловой картой вместо отдельных треугольников
+static const double LOD_PIXELS_PER_UNIT = 1.0;
+static const int DENSITY_BIN_PIXELS = 4;
+static const int DENSE_BIN_AGENTS = 3;
 
 Renderer::Renderer(int width, int height) 
-    : window_width(width), window_height(height), window(nullptr) {}
+    : window(nullptr), window_width(width), window_height(height),
+      framebuffer_width(width), framebuffer_height(height) {}
 
 Renderer::~Renderer() {
     if (window) {
@@ -40,28 +48,46 @@ bool Renderer::initialize() {
 }
 
 void Renderer::render(FlockSimulation& simulation) {
+    update_viewport();
+    
     glClear(GL_COLOR_BUFFER_BIT);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Темно-серый фон
     
-    // Настройка проекции - ФИКСИРОВАННЫЕ координаты
+    // Проекция по камере, с учетом текущих пропорций окна
+    double half_width = get_half_width();
+    Vector2 view_min = camera.center - Vector2(half_width, camera.half_height);
+    Vector2 view_max = camera.center + Vector2(half_width, camera.half_height);
+    
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glOrtho(-200, 200, -200, 200, -1, 1); // От -200 до +200 по обеим осям
+    glOrtho(view_min.x, view_max.x, view_min.y, view_max.y, -1, 1);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
     
-    // Получаем данные из симуляции
-    auto agents = simulation.get_agents();
-    auto obstacles = simulation.get_obstacles();
-    auto beta_agents = simulation.get_beta_agents();
-    auto target = simulation.get_target();
     bool show_betas = simulation.is_beta_display_enabled();
     bool target_enabled = simulation.is_target_enabled();
     bool show_connections = simulation.is_connections_display_enabled();
     
+    double pixels_per_unit = framebuffer_height / (2.0 * camera.half_height);
+    bool use_lod = density_lod && pixels_per_unit < LOD_PIXELS_PER_UNIT;
+    
+    // При сильном отдалении линии сливаются, поэтому связи не рисуем
+    bool draw_links = show_connections && !use_lod;
+    double interaction_range = simulation.get_interaction_range();
+    
+    // Отбираем только видимых агентов через пространственную сетку симуляции;
+    // запас на размер треугольника агента, а для связей - еще и на радиус r,
+    // чтобы не пропадали связи с соседями сразу за краем экрана
+    double agent_margin = 5.0 + (draw_links ? interaction_range : 0.0);
+    auto agents = simulation.get_agents_in_region(view_min - Vector2(agent_margin, agent_margin),
+                                                  view_max + Vector2(agent_margin, agent_margin));
+    auto obstacles = simulation.get_obstacles();
+    auto beta_agents = simulation.get_beta_agents();
+    auto target = simulation.get_target();
+    
     // Сначала рисуем соединения (чтобы они были под агентами)
-    if (show_connections) {
-        draw_connections(simulation);
+    if (draw_links) {
+        draw_connections(agents, beta_agents, interaction_range, simulation.get_obstacle_range());
     }
     
     // Рендерим цель только если она включена
@@ -71,6 +97,10 @@ void Renderer::render(FlockSimulation& simulation) {
     
     // Рендерим препятствия
     for (const auto& obstacle : obstacles) {
+        if (obstacle.position.x + obstacle.radius < view_min.x || obstacle.position.x - obstacle.radius > view_max.x ||
+            obstacle.position.y + obstacle.radius < view_min.y || obstacle.position.y - obstacle.radius > view_max.y) {
+            continue;
+        }
         draw_obstacle(obstacle);
     }
     
@@ -82,13 +112,100 @@ void Renderer::render(FlockSimulation& simulation) {
     }
     
     // Рендерим агентов
-    for (const auto& agent : agents) {
-        draw_agent(agent);
+    if (use_lod) {
+        draw_density(agents, view_min, view_max, pixels_per_unit);
+    } else {
+        for (const auto& agent : agents) {
+            draw_agent(agent);
+        }
     }
     
     glfwSwapBuffers(window);
 }
 
+void Renderer::update_viewport() {
+    // Размеры читаются каждый кадр, поэтому изменение окна учитывается сразу
+    glfwGetWindowSize(window, &window_width, &window_height);
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    window_width = std::max(1, window_width);
+    window_height = std::max(1, window_height);
+    framebuffer_width = std::max(1, framebuffer_width);
+    framebuffer_height = std::max(1, framebuffer_height);
+    
+    glViewport(0, 0, framebuffer_width, framebuffer_height);
+}
+
+double Renderer::get_half_width() const {
+    return camera.half_height * window_width / window_height;
+}
+
+void Renderer::zoom_at(double screen_x, double screen_y, double factor) {
+    // Точка мира под курсором остается на месте
+    Vector2 anchor = screen_to_world(screen_x, screen_y);
+    double half_height = std::min(1e6, std::max(2.0, camera.half_height * factor));
+    double applied = half_height / camera.half_height;
+    
+    camera.half_height = half_height;
+    camera.center = anchor - (anchor - camera.center) * applied;
+}
+
+void Renderer::pan_pixels(double dx, double dy) {
+    double units_per_pixel = 2.0 * camera.half_height / window_height;
+    camera.center.x -= dx * units_per_pixel;
+    camera.center.y += dy * units_per_pixel;
+}
+
+void Renderer::draw_density(const std::vector<Agent>& agents, const Vector2& view_min, const Vector2& view_max,
+                            double pixels_per_unit) {
+    // Гистограмма агентов по экранным ячейкам DENSITY_BIN_PIXELS x DENSITY_BIN_PIXELS
+    double bin_size = DENSITY_BIN_PIXELS / pixels_per_unit;
+    int cols = std::max(1, static_cast<int>(std::ceil((view_max.x - view_min.x) / bin_size)));
+    int rows = std::max(1, static_cast<int>(std::ceil((view_max.y - view_min.y) / bin_size)));
+    std::vector<int> counts(static_cast<size_t>(cols) * rows, 0);
+    
+    auto bin_of = [&](const Agent& agent) {
+        int bx = std::min(cols - 1, std::max(0, static_cast<int>((agent.position.x - view_min.x) / bin_size)));
+        int by = std::min(rows - 1, std::max(0, static_cast<int>((agent.position.y - view_min.y) / bin_size)));
+        return by * cols + bx;
+    };
+    
+    for (const auto& agent : agents) {
+        counts[bin_of(agent)]++;
+    }
+    
+    // Плотные ячейки: квадраты с цветом по числу агентов (голубой -> желтый -> белый)
+    glBegin(GL_QUADS);
+    for (int by = 0; by < rows; ++by) {
+        for (int bx = 0; bx < cols; ++bx) {
+            int count = counts[by * cols + bx];
+            if (count < DENSE_BIN_AGENTS) continue;
+            
+            float heat = std::min(1.0f, static_cast<float>(std::log2(count / double(DENSE_BIN_AGENTS)) / 5.0));
+            if (heat < 0.5f) {
+                glColor3f(2.0f * heat, 0.7f + 0.3f * 2.0f * heat, 1.0f - 2.0f * heat);
+            } else {
+                float w = 2.0f * (heat - 0.5f);
+                glColor3f(1.0f, 1.0f, w);
+            }
+            
+            double x = view_min.x + bx * bin_size;
+            double y = view_min.y + by * bin_size;
+            glVertex2f(x, y);
+            glVertex2f(x + bin_size, y);
+            glVertex2f(x + bin_size, y + bin_size);
+            glVertex2f(x, y + bin_size);
+        }
+    }
+    glEnd();
+    
+    // Редкие агенты рисуются как обычно
+    for (const auto& agent : agents) {
+        if (counts[bin_of(agent)] < DENSE_BIN_AGENTS) {
+            draw_agent(agent);
+        }
+    }
+}
+
 void Renderer::draw_agent(const Agent& agent) {
     Vector2 direction = agent.velocity.length() > 0.1 ? 
                        agent.velocity.normalized() : Vector2(1, 0);
@@ -115,6 +232,17 @@ void Renderer::draw_obstacle(const Obstacle& obstacle) {
                    obstacle.position.y + obstacle.radius * sin(angle));
     }
     glEnd();
+    
+    // Стрелка скорости для движущихся препятствий
+    if (obstacle.velocity.length() > 0.5) {
+        Vector2 dir = obstacle.velocity.normalized();
+        double length = obstacle.radius + 8.0;
+        glColor3f(1.0f, 0.6f, 0.6f);
+        glBegin(GL_LINES);
+        glVertex2f(obstacle.position.x, obstacle.position.y);
+        glVertex2f(obstacle.position.x + dir.x * length, obstacle.position.y + dir.y * length);
+        glEnd();
+    }
 }
 
 void Renderer::draw_beta_agent(const BetaAgent& beta_agent) {
@@ -156,11 +284,13 @@ void Renderer::draw_target(const Vector2& target) {
     glEnd();
 }
 
-void Renderer::draw_connections(const FlockSimulation& simulation) {
-    auto agents = simulation.get_agents();
-    auto beta_agents = simulation.get_beta_agents();
-    double interaction_range = simulation.get_interaction_range();
-    double obstacle_range = simulation.get_obstacle_range();
+void Renderer::draw_connections(const std::vector<Agent>& visible_agents, const std::vector<BetaAgent>& beta_agents,
+                                double interaction_range, double obstacle_range) {
+    // Агенты по возрастанию x: соседей ищем только в полосе шириной r
+    std::vector<Agent> agents = visible_agents;
+    std::sort(agents.begin(), agents.end(), [](const Agent& a, const Agent& b) {
+        return a.position.x < b.position.x;
+    });
     
     // Включаем прозрачность для линий
     glEnable(GL_BLEND);
@@ -170,7 +300,7 @@ void Renderer::draw_connections(const FlockSimulation& simulation) {
     glColor4f(1.0f, 1.0f, 1.0f, 0.4f);
     glBegin(GL_LINES);
     for (size_t i = 0; i < agents.size(); ++i) {
-        for (size_t j = i + 1; j < agents.size(); ++j) {
+        for (size_t j = i + 1; j < agents.size() && agents[j].position.x - agents[i].position.x < interaction_range; ++j) {
             Vector2 diff = agents[j].position - agents[i].position;
             double distance = diff.length();
             if (distance < interaction_range) {
@@ -187,8 +317,11 @@ void Renderer::draw_connections(const FlockSimulation& simulation) {
     // Рисуем связи между α-агентами и β-агентами (оранжевые линии)
     glColor4f(1.0f, 0.5f, 0.0f, 0.4f); // Полупрозрачный оранжевый
     glBegin(GL_LINES);
-    for (const auto& agent : agents) {
-        for (const auto& beta_agent : beta_agents) {
+    for (const auto& beta_agent : beta_agents) {
+        auto first = std::lower_bound(agents.begin(), agents.end(), beta_agent.position.x - obstacle_range,
+                                      [](const Agent& agent, double x) { return agent.position.x < x; });
+        for (auto it = first; it != agents.end() && it->position.x < beta_agent.position.x + obstacle_range; ++it) {
+            const Agent& agent = *it;
             Vector2 diff = beta_agent.position - agent.position;
             double distance = diff.length();
             if (distance < obstacle_range) {
@@ -214,11 +347,10 @@ void Renderer::poll_events() {
 }
 
 Vector2 Renderer::screen_to_world(double screen_x, double screen_y) const {
-    // СУПЕР-ПРОСТОЙ вариант - гарантированно работает
-    // Предполагаем что окно 1000x800, мир 400x400
-    
-    double world_x = (screen_x / 1000.0) * 400.0 - 200.0;
-    double world_y = 200.0 - (screen_y / 800.0) * 400.0;
+    // Координаты курсора GLFW - в единицах окна, начало в левом верхнем углу
+    double half_width = get_half_width();
+    double world_x = camera.center.x + (2.0 * screen_x / window_width - 1.0) * half_width;
+    double world_y = camera.center.y + (1.0 - 2.0 * screen_y / window_height) * camera.half_height;
     
     return Vector2(world_x, world_y);
 }
\ No newline at end of file
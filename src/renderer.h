@@ -2,10 +2,20 @@
 #include "simulation.h"
 #include <GLFW/glfw3.h>
 
+// Камера: центр и половина видимой высоты в мировых координатах;
+// видимая ширина следует из пропорций окна
+struct Camera {
+    Vector2 center = Vector2(0, 0);
+    double half_height = 200.0;
+};
+
 class Renderer {
 private:
     GLFWwindow* window;
     int window_width, window_height;
+    int framebuffer_width, framebuffer_height; // может отличаться от окна на HiDPI
+    Camera camera;
+    bool density_lod = true;
     
 public:
     Renderer(int width = 800, int height = 600);
@@ -21,10 +31,23 @@ public:
     int get_window_width() const { return window_width; }
     int get_window_height() const { return window_height; }
     
+    // Управление камерой
+    void zoom_at(double screen_x, double screen_y, double factor);
+    void pan_pixels(double dx, double dy);
+    void reset_camera() { camera = Camera(); }
+    void toggle_density_lod() { density_lod = !density_lod; }
+    bool is_density_lod_enabled() const { return density_lod; }
+    
 private:
+    void update_viewport();
+    double get_half_width() const;
+    
     void draw_agent(const Agent& agent);
     void draw_obstacle(const Obstacle& obstacle);
     void draw_beta_agent(const BetaAgent& beta_agent);
     void draw_target(const Vector2& target);
-    void draw_connections(const FlockSimulation& simulation); // НОВОЕ: отрисовка сетки связей
-};
\ No newline at end of file
+    void draw_connections(const std::vector<Agent>& agents, const std::vector<BetaAgent>& beta_agents,
+                          double interaction_range, double obstacle_range); // НОВОЕ: отрисовка сетки связей
+    void draw_density(const std::vector<Agent>& agents, const Vector2& view_min, const Vector2& view_max,
+                      double pixels_per_unit);
+};
@@ -0,0 +1,246 @@
+#include "shm_exporter.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// POSIX требует, чтобы имя объекта начиналось с '/'
+std::string normalize_name(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+// Размер слота с выравниванием массивов по 64 байта
+uint64_t compute_slot_size(uint32_t agent_capacity) {
+    uint64_t header_size = (sizeof(ShmSlotHeader) + 63) / 64 * 64;
+    uint64_t array_size = (agent_capacity * sizeof(double) + 63) / 64 * 64;
+    return header_size + 5 * array_size;
+}
+
+double* slot_array(ShmSlotHeader* slot, uint32_t agent_capacity, int array_index) {
+    uint64_t header_size = (sizeof(ShmSlotHeader) + 63) / 64 * 64;
+    uint64_t array_size = (agent_capacity * sizeof(double) + 63) / 64 * 64;
+    return reinterpret_cast<double*>(reinterpret_cast<char*>(slot) + header_size + array_index * array_size);
+}
+
+const double* slot_array(const ShmSlotHeader* slot, uint32_t agent_capacity, int array_index) {
+    return slot_array(const_cast<ShmSlotHeader*>(slot), agent_capacity, array_index);
+}
+
+} // namespace
+
+ShmExporter::~ShmExporter() {
+    close();
+}
+
+bool ShmExporter::open(const std::string& requested_name, uint32_t agent_capacity, uint32_t slot_count) {
+#ifdef _WIN32
+    std::cerr << "Shared-memory export is not supported on Windows" << std::endl;
+    return false;
+#else
+    close();
+    std::string name = normalize_name(requested_name);
+
+    uint64_t header_size = (sizeof(ShmHeader) + 63) / 64 * 64;
+    uint64_t slot_size = compute_slot_size(agent_capacity);
+    size_t size = header_size + slot_size * slot_count;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+        std::cerr << "Failed to resize shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    std::memset(memory, 0, size);
+    header = static_cast<ShmHeader*>(memory);
+    header->slot_count = slot_count;
+    header->agent_capacity = agent_capacity;
+    header->slot_size = slot_size;
+    header->header_size = header_size;
+    header->version = SHM_VERSION;
+
+    // magic записывается последним: читатель не примет наполовину созданный заголовок
+    std::atomic_thread_fence(std::memory_order_release);
+    reinterpret_cast<std::atomic<uint32_t>*>(&header->magic)->store(SHM_MAGIC, std::memory_order_release);
+
+    shm_name = name;
+    mapping_size = size;
+    next_frame = 0;
+
+    std::cout << "Shared-memory export: /dev/shm" << name << " (" << slot_count << " slots, "
+              << agent_capacity << " agents)" << std::endl;
+    return true;
+#endif
+}
+
+void ShmExporter::close() {
+#ifndef _WIN32
+    if (header) {
+        munmap(header, mapping_size);
+        shm_unlink(shm_name.c_str());
+        header = nullptr;
+    }
+#endif
+}
+
+void ShmExporter::publish(const std::vector<Agent>& agents, const Vector2& target, bool target_enabled, double time) {
+    if (!header) return;
+
+    uint32_t capacity = header->agent_capacity;
+    uint64_t frame = next_frame++;
+    char* base = reinterpret_cast<char*>(header) + header->header_size;
+    ShmSlotHeader* slot = reinterpret_cast<ShmSlotHeader*>(base + (frame % header->slot_count) * header->slot_size);
+
+    // Открываем запись: нечетный sequence
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(agents.size(), capacity));
+    slot->frame = frame;
+    slot->time = time;
+    slot->agent_count = count;
+    slot->target_enabled = target_enabled ? 1 : 0;
+    slot->target_x = target.x;
+    slot->target_y = target.y;
+
+    double* pos_x = slot_array(slot, capacity, 0);
+    double* pos_y = slot_array(slot, capacity, 1);
+    double* vel_x = slot_array(slot, capacity, 2);
+    double* vel_y = slot_array(slot, capacity, 3);
+    uint32_t* id = reinterpret_cast<uint32_t*>(slot_array(slot, capacity, 4));
+    for (uint32_t i = 0; i < count; ++i) {
+        pos_x[i] = agents[i].position.x;
+        pos_y[i] = agents[i].position.y;
+        vel_x[i] = agents[i].velocity.x;
+        vel_y[i] = agents[i].velocity.y;
+        id[i] = agents[i].id;
+    }
+
+    // Закрываем запись: четный sequence, затем объявляем кадр последним
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header->latest_frame.store(frame + 1, std::memory_order_release);
+}
+
+ShmReader::~ShmReader() {
+    close();
+}
+
+bool ShmReader::open(const std::string& requested_name) {
+#ifdef _WIN32
+    std::cerr << "Shared-memory export is not supported on Windows" << std::endl;
+    return false;
+#else
+    close();
+    std::string name = normalize_name(requested_name);
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to open shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShmHeader)) {
+        std::cerr << "Shared memory " << name << " is too small" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const ShmHeader* mapped = static_cast<const ShmHeader*>(memory);
+    uint32_t magic = reinterpret_cast<const std::atomic<uint32_t>*>(&mapped->magic)->load(std::memory_order_acquire);
+    bool valid = magic == SHM_MAGIC && mapped->version == SHM_VERSION &&
+                 mapped->header_size + mapped->slot_size * mapped->slot_count <= static_cast<uint64_t>(info.st_size);
+    if (!valid) {
+        std::cerr << "Shared memory " << name << " has unsupported format" << std::endl;
+        munmap(memory, info.st_size);
+        return false;
+    }
+
+    header = mapped;
+    mapping_size = info.st_size;
+    return true;
+#endif
+}
+
+void ShmReader::close() {
+#ifndef _WIN32
+    if (header) {
+        munmap(const_cast<ShmHeader*>(header), mapping_size);
+        header = nullptr;
+    }
+#endif
+}
+
+uint64_t ShmReader::latest_frame() const {
+    if (!header) return 0;
+    return header->latest_frame.load(std::memory_order_acquire);
+}
+
+const ShmSlotHeader* ShmReader::slot_at(uint32_t index) const {
+    const char* base = reinterpret_cast<const char*>(header) + header->header_size;
+    return reinterpret_cast<const ShmSlotHeader*>(base + index * header->slot_size);
+}
+
+bool ShmReader::acquire(uint64_t frame, ShmFrameView& view) const {
+    if (!header) return false;
+
+    const ShmSlotHeader* slot = slot_at(frame % header->slot_count);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence & 1) return false; // слот записывается
+    if (slot->frame != frame) return false; // кадр уже вытеснен
+
+    uint32_t capacity = header->agent_capacity;
+    view.frame = frame;
+    view.sequence = sequence;
+    view.time = slot->time;
+    view.agent_count = std::min(slot->agent_count, capacity);
+    view.target_enabled = slot->target_enabled != 0;
+    view.target = Vector2(slot->target_x, slot->target_y);
+    view.pos_x = slot_array(slot, capacity, 0);
+    view.pos_y = slot_array(slot, capacity, 1);
+    view.vel_x = slot_array(slot, capacity, 2);
+    view.vel_y = slot_array(slot, capacity, 3);
+    view.id = reinterpret_cast<const uint32_t*>(slot_array(slot, capacity, 4));
+    view.slot = slot;
+
+    return validate(view);
+}
+
+bool ShmReader::acquire_latest(ShmFrameView& view) const {
+    uint64_t latest = latest_frame();
+    if (latest == 0) return false;
+    return acquire(latest - 1, view);
+}
+
+bool ShmReader::validate(const ShmFrameView& view) const {
+    if (!view.slot) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
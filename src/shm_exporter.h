@@ -0,0 +1,105 @@
+#pragma once
+#include "simulation.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Формат разделяемой памяти (POSIX shm):
+//   ShmHeader | слот 0 | слот 1 | ... | слот slot_count - 1
+// Слот: ShmSlotHeader, затем массивы SoA по agent_capacity элементов:
+//   pos_x, pos_y, vel_x, vel_y (double), id (uint32_t).
+// Порядок агентов в слоте меняется от кадра к кадру (симуляция сортирует
+// их по ячейкам сетки), поэтому агента между кадрами отслеживают по id.
+// Слот публикуется по схеме seqlock: нечетный sequence - идет запись.
+constexpr uint32_t SHM_MAGIC = 0x4B434C46; // "FLCK"
+constexpr uint32_t SHM_VERSION = 2;
+
+struct ShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t agent_capacity;
+    uint64_t slot_size;    // байт на слот, включая заголовок слота
+    uint64_t header_size;  // смещение первого слота
+    std::atomic<uint64_t> latest_frame; // номер последнего кадра + 1 (0 - кадров еще нет)
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> sequence;
+    uint64_t frame;
+    double time;
+    uint32_t agent_count;
+    uint32_t target_enabled;
+    double target_x, target_y;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory seqlock needs lock-free 64-bit atomics");
+
+// Кадр, указывающий прямо в разделяемую память (без копирования)
+struct ShmFrameView {
+    uint64_t frame = 0;
+    uint64_t sequence = 0;
+    double time = 0.0;
+    uint32_t agent_count = 0;
+    bool target_enabled = false;
+    Vector2 target;
+    const double* pos_x = nullptr;
+    const double* pos_y = nullptr;
+    const double* vel_x = nullptr;
+    const double* vel_y = nullptr;
+    const uint32_t* id = nullptr;
+    const ShmSlotHeader* slot = nullptr;
+};
+
+// Публикация кадров симуляции в кольцевой буфер разделяемой памяти
+class ShmExporter {
+public:
+    ShmExporter() = default;
+    ~ShmExporter();
+
+    ShmExporter(const ShmExporter&) = delete;
+    ShmExporter& operator=(const ShmExporter&) = delete;
+
+    bool open(const std::string& name, uint32_t agent_capacity, uint32_t slot_count = 4);
+    void close();
+    bool is_open() const { return header != nullptr; }
+
+    // Агенты сверх agent_capacity отбрасываются
+    void publish(const std::vector<Agent>& agents, const Vector2& target, bool target_enabled, double time);
+
+private:
+    std::string shm_name;
+    size_t mapping_size = 0;
+    ShmHeader* header = nullptr;
+    uint64_t next_frame = 0;
+};
+
+// Читатель кольцевого буфера, отображенного только для чтения
+class ShmReader {
+public:
+    ShmReader() = default;
+    ~ShmReader();
+
+    ShmReader(const ShmReader&) = delete;
+    ShmReader& operator=(const ShmReader&) = delete;
+
+    bool open(const std::string& name);
+    void close();
+
+    uint64_t latest_frame() const;
+    uint32_t get_slot_count() const { return header ? header->slot_count : 0; }
+    uint32_t get_agent_capacity() const { return header ? header->agent_capacity : 0; }
+
+    // Кадр frame, если он еще в буфере и не записывается в данный момент.
+    // После чтения данных нужно проверить validate(): если кадр успели
+    // перезаписать, прочитанное следует отбросить.
+    bool acquire(uint64_t frame, ShmFrameView& view) const;
+    bool acquire_latest(ShmFrameView& view) const;
+    bool validate(const ShmFrameView& view) const;
+
+private:
+    size_t mapping_size = 0;
+    const ShmHeader* header = nullptr;
+
+    const ShmSlotHeader* slot_at(uint32_t index) const;
+};
@@ -0,0 +1,61 @@
+// Пример читателя кадров из разделяемой памяти.
+// Запуск: flocking_shm_reader <имя> (то же, что в --export-shm)
+#include "shm_exporter.h"
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <shm-name>" << std::endl;
+        return -1;
+    }
+    
+    ShmReader reader;
+    if (!reader.open(argv[1])) {
+        return -1;
+    }
+    
+    std::cout << "Attached to " << argv[1] << ": " << reader.get_slot_count() << " slots, "
+              << reader.get_agent_capacity() << " agents" << std::endl;
+    
+    uint64_t last_frame = 0;
+    while (true) {
+        uint64_t latest = reader.latest_frame();
+        if (latest == last_frame) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        
+        ShmFrameView frame;
+        if (!reader.acquire_latest(frame)) continue; // кадр перезаписывается, пробуем следующий
+        
+        // Считаем статистику прямо по отображенным массивам
+        double center_x = 0, center_y = 0, speed = 0;
+        for (uint32_t i = 0; i < frame.agent_count; ++i) {
+            center_x += frame.pos_x[i];
+            center_y += frame.pos_y[i];
+            speed += std::sqrt(frame.vel_x[i] * frame.vel_x[i] + frame.vel_y[i] * frame.vel_y[i]);
+        }
+        
+        // Писатель успел перезаписать слот - результат недостоверен
+        if (!reader.validate(frame)) continue;
+        
+        if (frame.agent_count > 0) {
+            center_x /= frame.agent_count;
+            center_y /= frame.agent_count;
+            speed /= frame.agent_count;
+        }
+        
+        std::cout << std::fixed << std::setprecision(2)
+                  << "frame " << frame.frame << " t=" << frame.time
+                  << " agents=" << frame.agent_count
+                  << " center=(" << center_x << ", " << center_y << ")"
+                  << " mean speed=" << speed
+                  << " skipped=" << (latest - 1 - last_frame) << std::endl;
+        last_frame = latest;
+    }
+    
+    return 0;
+}
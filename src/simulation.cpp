@@ -1,35 +1,113 @@
 #include "simulation.h"
 
-FlockSimulation::FlockSimulation() : gamma_target(100, 100), gamma_velocity(0, 0) {
+// Ограничение максимальной скорости для стабильности
+static const double MAX_AGENT_SPEED = 100.0;
+
+// Половина стороны области для стаи из 1000 агентов
+static const double DEFAULT_WORLD_BOUND = 200.0;
+
+template <int D>
+BasicFlockSimulation<D>::BasicFlockSimulation(TaskScheduler* scheduler)
+    : scheduler(scheduler) {
+    create_default_group();
+    
     // Инициализация случайного генератора
     std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(-150, 150);
+    spawn_agents(1000, rd());
+}
+
+template <int D>
+BasicFlockSimulation<D>::BasicFlockSimulation(const Parameters& parameters, size_t agent_count, unsigned seed,
+                                              TaskScheduler* scheduler)
+    : scheduler(scheduler), params(parameters) {
+    create_default_group();
+    spawn_agents(agent_count, seed);
+}
+
+template <int D>
+void BasicFlockSimulation<D>::spawn_agents(size_t count, unsigned seed) {
+    std::mt19937 gen(seed);
+    // 1000 агентов в квадрате (кубе) ±150; плотность сохраняется при другом числе агентов
+    double extent = 150.0 * std::pow(count / 1000.0, 1.0 / D);
+    std::uniform_real_distribution<> dis(-extent, extent);
+    
+    // Граница области растет вместе с областью появления, иначе
+    // большая стая с самого начала оказывается за мягкой границей
+    world_bound = std::max(DEFAULT_WORLD_BOUND, extent * DEFAULT_WORLD_BOUND / 150.0);
+    std::uniform_real_distribution<> speed(-7.5, 7.5);
     
     // Создаем случайных агентов
-    for (int i = 0; i < 1000; ++i) {
-        agents.emplace_back(Vector2(dis(gen), dis(gen)));
+    agents.clear();
+    for (size_t i = 0; i < count; ++i) {
+        Vec position;
+        for (int axis = 0; axis < D; ++axis) position[axis] = dis(gen);
+        agents.emplace_back(position, 0, static_cast<uint32_t>(i));
         
         // Добавляем небольшую случайную начальную скорость
-        agents.back().velocity = Vector2(dis(gen) * 0.05, dis(gen) * 0.05);
+        for (int axis = 0; axis < D; ++axis) agents.back().velocity[axis] = speed(gen);
+    }
+    
+    agents_snapshot = agents;
+}
+
+template <int D>
+void BasicFlockSimulation<D>::create_default_group() {
+    GroupType group;
+    group.params = params;
+    group.target = Vec(100, 100);
+    group_kernels.push_back(make_group_kernel(group));
+    update_group_ranges();
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::make_group_kernel(const GroupType& settings) -> GroupKernel {
+    const Parameters& group_params = settings.params;
+    GroupKernel kernel;
+    kernel.settings = settings;
+    kernel.r_alpha = sigma_norm(Vec(group_params.interaction_range, 0), group_params.epsilon);
+    kernel.d_alpha = sigma_norm(Vec(group_params.desired_distance, 0), group_params.epsilon);
+    kernel.d_beta = sigma_norm(Vec(group_params.desired_distance * 0.6, 0), group_params.epsilon); // d_β
+    
+    const PotentialTable& table = find_potential_table(kernel);
+    kernel.potential = table.values.data();
+    kernel.potential_last = static_cast<int>(table.values.size()) - 1;
+    kernel.potential_step = kernel.r_alpha / kernel.potential_last;
+    return kernel;
+}
+
+template <int D>
+void BasicFlockSimulation<D>::update_group_ranges() {
+    double interaction = 0.0, obstacle = 0.0;
+    for (const auto& kernel : group_kernels) {
+        interaction = std::max(interaction, kernel.settings.params.interaction_range);
+        obstacle = std::max(obstacle, kernel.settings.params.obstacle_range);
     }
+    
+    // Окрестности препятствий в хеш-сетке должны покрывать наибольший r'
+    bool obstacle_range_changed = obstacle != max_obstacle_range;
+    max_interaction_range = interaction;
+    max_obstacle_range = obstacle;
+    if (obstacle_range_changed) rebuild_obstacle_grid();
 }
 
 // σ-норма из уравнения (8)
-double FlockSimulation::sigma_norm(const Vector2& z) const {
+template <int D>
+double BasicFlockSimulation<D>::sigma_norm(const Vec& z, double epsilon) {
     double norm_z = z.length();
-    return (1.0 / params.epsilon) * (std::sqrt(1.0 + params.epsilon * norm_z * norm_z) - 1.0);
+    return (1.0 / epsilon) * (std::sqrt(1.0 + epsilon * norm_z * norm_z) - 1.0);
 }
 
 // σ_ε из уравнения (9)
-Vector2 FlockSimulation::sigma_epsilon(const Vector2& z) const {
+template <int D>
+auto BasicFlockSimulation<D>::sigma_epsilon(const Vec& z, double epsilon) -> Vec {
     double norm_z = z.length();
-    if (norm_z < 1e-10) return Vector2(0, 0);
-    return z * (1.0 / std::sqrt(1.0 + params.epsilon * norm_z * norm_z));
+    if (norm_z < 1e-10) return Vec();
+    return z * (1.0 / std::sqrt(1.0 + epsilon * norm_z * norm_z));
 }
 
 // Bump-функция из уравнения (10)
-double FlockSimulation::bump_function(double z, double h) const {
+template <int D>
+double BasicFlockSimulation<D>::bump_function(double z, double h) {
     if (z < h) {
         return 1.0;
     } else if (z < 1.0) {
@@ -39,243 +117,1141 @@ double FlockSimulation::bump_function(double z, double h) const {
     }
 }
 
-// Матрица смежности для α-агентов
-double FlockSimulation::alpha_adjacency(const Vector2& q_i, const Vector2& q_j) const {
-    double distance = sigma_norm(q_j - q_i);
-    double r_alpha = sigma_norm(Vector2(params.interaction_range, 0));
-    return bump_function(distance / r_alpha, params.h_alpha);
-}
-
-// Матрица смежности для β-агентов  
-double FlockSimulation::beta_adjacency(const Vector2& q_i, const Vector2& obstacle_pos) const {
-    double distance = sigma_norm(obstacle_pos - q_i);
-    double d_beta = sigma_norm(Vector2(params.desired_distance * 0.6, 0)); // d_β
-    return bump_function(distance / d_beta, params.h_beta); // использовать d_β
-}
-
 // Функция действия φ_α из уравнения (15)
-double FlockSimulation::phi_alpha(double z) const {
-    double d_alpha = sigma_norm(Vector2(params.desired_distance, 0));
-    double r_alpha = sigma_norm(Vector2(params.interaction_range, 0));
-    
+template <int D>
+double BasicFlockSimulation<D>::phi_alpha(double z, const GroupKernel& kernel) {
     // Упрощенная версия - можно расширить согласно уравнению (15)
-    double bump = bump_function(z / r_alpha, params.h_alpha);
-    double action = (z - d_alpha) / std::sqrt(1.0 + (z - d_alpha) * (z - d_alpha));
+    double bump = bump_function(z / kernel.r_alpha, kernel.settings.params.h_alpha);
+    double s = z - kernel.d_alpha;
+    double action = s / std::sqrt(1.0 + s * s);
     
     return bump * action;
 }
 
 // Функция действия φ_β из уравнения (65)
-double FlockSimulation::phi_beta(double z) const {
-    double d_beta = sigma_norm(Vector2(params.desired_distance * 0.6, 0));
-    
-    double bump = bump_function(z / d_beta, params.h_beta); // z/d_β, а не z/r_β
+template <int D>
+double BasicFlockSimulation<D>::phi_beta(double z, const GroupKernel& kernel) {
+    double bump = bump_function(z / kernel.d_beta, kernel.settings.params.h_beta); // z/d_β, а не z/r_β
     
     // Правильная реализация по уравнению (65)
-    double s = z - d_beta;
+    double s = z - kernel.d_beta;
     double sigma1 = s / std::sqrt(1.0 + s * s); // σ_1(z - d_β)
     double action = sigma1 - 1.0;
     
     return bump * action;
 }
 
-void FlockSimulation::step(double delta_time) {
+// Таблица ψ_α: интеграл φ_α методом трапеций, ноль в точке d_α.
+// ψ_α зависит только от r, d, ε и h_α, поэтому таблица ищется среди готовых.
+template <int D>
+auto BasicFlockSimulation<D>::find_potential_table(const GroupKernel& kernel) -> const PotentialTable& {
+    const Parameters& group_params = kernel.settings.params;
+    for (const auto& table : potential_tables) {
+        if (table.params.interaction_range == group_params.interaction_range &&
+            table.params.desired_distance == group_params.desired_distance &&
+            table.params.epsilon == group_params.epsilon && table.params.h_alpha == group_params.h_alpha) {
+            return table;
+        }
+    }
+    
+    const int samples = 1024;
+    double step = kernel.r_alpha / samples;
+    
+    PotentialTable table;
+    table.params = group_params;
+    std::vector<double>& values = table.values;
+    values.assign(samples + 1, 0.0);
+    for (int k = 1; k <= samples; ++k) {
+        double z0 = (k - 1) * step;
+        double z1 = k * step;
+        values[k] = values[k - 1] + 0.5 * (phi_alpha(z0, kernel) + phi_alpha(z1, kernel)) * step;
+    }
+    
+    double zero_at = kernel.d_alpha / step;
+    int k = std::min(samples - 1, static_cast<int>(zero_at));
+    double offset = values[k] + (values[k + 1] - values[k]) * (zero_at - k);
+    for (double& value : values) {
+        value -= offset;
+    }
+    
+    // Перемещение вектора не меняет его буфер: указатели групп остаются верными
+    potential_tables.push_back(std::move(table));
+    return potential_tables.back();
+}
+
+template <int D>
+double BasicFlockSimulation<D>::psi_alpha(double z, const GroupKernel& kernel) {
+    double position = z / kernel.potential_step;
+    if (position >= kernel.potential_last) return kernel.potential[kernel.potential_last];
+    
+    int k = static_cast<int>(position);
+    return kernel.potential[k] + (kernel.potential[k + 1] - kernel.potential[k]) * (position - k);
+}
+
+template <int D>
+void BasicFlockSimulation<D>::step(double delta_time) {
     std::lock_guard<std::mutex> lock(data_mutex);
+    advance(delta_time, true);
+}
+
+template <int D>
+void BasicFlockSimulation<D>::step_n(size_t count, double delta_time) {
+    // Блокировка, выбор ядра и граф задач - один раз на пакет; промежуточные
+    // шаги не копируют агентов в снимок
+    std::lock_guard<std::mutex> lock(data_mutex);
+    for (size_t i = 0; i < count; ++i) {
+        advance(delta_time, i + 1 == count);
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::advance(double delta_time, bool publish) {
+    step_dt = delta_time;
+    publish_step = publish;
+    move_obstacles(delta_time);
+    build_spatial_grid();
+    build_step_graph();
+    
+    if (metrics_config.enabled) {
+        components.reset(agents.size());
+        tile_metrics.assign(grid.tile_count(), MetricsAccumulator());
+    }
     
-    // Обновляем β-агентов
-    update_beta_agents();
+    // β-агенты, силы и интегрирование выполняются по тайлам: задачи тайла
+    // ждут только соседние тайлы, а не весь предыдущий этап
+    scheduler->run(step_graph);
     
-    // Обновляем ускорения для всех агентов согласно Algorithm 3
-    for (auto& agent : agents) {
-        Vector2 alpha_force = compute_alpha_force(agent);
-        Vector2 beta_force = compute_beta_force(agent);
-        Vector2 gamma_force = compute_gamma_force(agent);
-        
-        // Суммируем все силы согласно уравнению (67)
-        agent.acceleration = alpha_force + beta_force + gamma_force;
+    // После удаления призраков индексы снимка не совпадают с сеткой
+    bool grid_matches_snapshot = ghost_flags.empty();
+    
+    // Сводка метрик до удаления призраков: индексы системы множеств - индексы шага
+    FlockMetrics metrics;
+    if (metrics_config.enabled) {
+        metrics = reduce_metrics();
+        metrics.time = simulation_time - delta_time;
     }
     
-    // Обновляем позиции и скорости
-    for (auto& agent : agents) {
-        // Интегрирование скорости (уравнение движения (2))
-        agent.velocity = agent.velocity + agent.acceleration * delta_time;
-        
-        // Ограничение максимальной скорости для стабильности
-        double speed = agent.velocity.length();
-        double max_speed = 100.0;
-        if (speed > max_speed) {
-            agent.velocity = agent.velocity.normalized() * max_speed;
+    if (!grid_matches_snapshot) {
+        remove_ghosts();
+    }
+    
+    beta_agents.clear();
+    for (const auto& tile_betas : tile_beta_agents) {
+        beta_agents.insert(beta_agents.end(), tile_betas.begin(), tile_betas.end());
+    }
+    
+    if (publish || metrics_config.enabled) {
+        std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
+        if (publish) {
+            agents_snapshot.swap(snapshot_back);
+            
+            // Сетка шага публикуется вместе со снимком (обменом: следующий шаг
+            // все равно перестроит grid). Ячейки посчитаны до интегрирования,
+            // поэтому агенты могли сместиться не дальше чем на MAX_AGENT_SPEED * dt
+            std::swap(snapshot_grid, grid);
+            snapshot_grid_valid = grid_matches_snapshot;
+            snapshot_grid_margin = MAX_AGENT_SPEED * delta_time;
         }
         
-        // Интегрирование позиции
-        agent.position = agent.position + agent.velocity * delta_time;
-        
-        // Мягкое ограничение области
-        const double boundary = 200.0;
-        const double soft_boundary = 180.0;
-        
-        if (std::abs(agent.position.x) > soft_boundary) {
-            double push = (boundary - std::abs(agent.position.x)) / (boundary - soft_boundary);
-            agent.velocity.x += (agent.position.x > 0 ? -1 : 1) * push * 5.0;
+        if (metrics_config.enabled) {
+            latest_metrics = metrics;
+            metrics_history.push_back(metrics);
+            while (metrics_config.history_limit > 0 && metrics_history.size() > metrics_config.history_limit) {
+                metrics_history.pop_front();
+            }
         }
-        if (std::abs(agent.position.y) > soft_boundary) {
-            double push = (boundary - std::abs(agent.position.y)) / (boundary - soft_boundary);
-            agent.velocity.y += (agent.position.y > 0 ? -1 : 1) * push * 5.0;
+    }
+    
+    if (step_observer) {
+        step_observer(agents, group_kernels[0].settings.target, use_gamma_target, simulation_time);
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::build_spatial_grid() {
+    // Призраки на время шага добавляются в конец массива агентов
+    ghost_flags.clear();
+    if (!ghost_agents.empty()) {
+        ghost_flags.assign(agents.size(), 0);
+        ghost_flags.resize(agents.size() + ghost_agents.size(), 1);
+        agents.insert(agents.end(), ghost_agents.begin(), ghost_agents.end());
+    }
+    
+    if (agents.empty()) {
+        // Пустая стая тоже публикуется: иначе остались бы снимок и β-агенты прошлого шага
+        grid = Grid();
+        grid.cell_start.assign(1, 0);
+        tile_beta_agents.clear();
+        if (publish_step) snapshot_back.clear();
+        return;
+    }
+    
+    Vec min_pos = agents[0].position;
+    Vec max_pos = agents[0].position;
+    for (const auto& agent : agents) {
+        for (int axis = 0; axis < D; ++axis) {
+            min_pos[axis] = std::min(min_pos[axis], agent.position[axis]);
+            max_pos[axis] = std::max(max_pos[axis], agent.position[axis]);
         }
     }
+    
+    // Ячейка покрывает и α-соседей, и β-агентов, порожденных соседями
+    // (β-агент лежит не дальше r' от породившего его агента)
+    double cell_size = std::max(max_interaction_range, 2.0 * max_obstacle_range);
+    const int max_cells_per_axis = D == 2 ? 1024 : 128;
+    double extent = 0.0;
+    for (int axis = 0; axis < D; ++axis) {
+        extent = std::max(extent, max_pos[axis] - min_pos[axis]);
+    }
+    if (extent / cell_size > max_cells_per_axis) {
+        cell_size = extent / max_cells_per_axis;
+    }
+    
+    grid.origin = min_pos;
+    grid.cell_size = cell_size;
+    grid.cols = static_cast<int>((max_pos.x - min_pos.x) / cell_size) + 1;
+    grid.rows = static_cast<int>((max_pos.y - min_pos.y) / cell_size) + 1;
+    if constexpr (D == 3) {
+        grid.layers = static_cast<int>((max_pos.z - min_pos.z) / cell_size) + 1;
+    }
+    
+    // Около 8 тайлов на поток, чтобы кражи работы сглаживали неравномерность стаи
+    unsigned threads = scheduler->get_thread_count();
+    int target_tiles = threads > 1 ? static_cast<int>(threads) * 8 : 1;
+    double cells_per_tile = static_cast<double>(grid.cols) * grid.rows / target_tiles;
+    grid.tile_span = std::max(1, static_cast<int>(std::ceil(std::sqrt(cells_per_tile))));
+    grid.tile_cols = (grid.cols + grid.tile_span - 1) / grid.tile_span;
+    grid.tile_rows = (grid.rows + grid.tile_span - 1) / grid.tile_span;
+    
+    // Сортировка подсчетом по ключу ячейки
+    size_t key_count = static_cast<size_t>(grid.tile_count()) * grid.cells_per_tile();
+    grid.cell_start.assign(key_count + 1, 0);
+    agent_keys.resize(agents.size());
+    
+    for (size_t i = 0; i < agents.size(); ++i) {
+        int key = grid.cell_key(agents[i].position);
+        agent_keys[i] = key;
+        grid.cell_start[key + 1]++;
+    }
+    for (size_t key = 0; key < key_count; ++key) {
+        grid.cell_start[key + 1] += grid.cell_start[key];
+    }
+    
+    sorted_agents.resize(agents.size());
+    bool has_ghosts = !ghost_flags.empty();
+    if (has_ghosts) sorted_flags.resize(agents.size());
+    
+    cell_cursor.assign(grid.cell_start.begin(), grid.cell_start.end() - 1);
+    for (size_t i = 0; i < agents.size(); ++i) {
+        size_t target = cell_cursor[agent_keys[i]]++;
+        sorted_agents[target] = agents[i];
+        if (has_ghosts) sorted_flags[target] = ghost_flags[i];
+    }
+    agents.swap(sorted_agents);
+    if (has_ghosts) ghost_flags.swap(sorted_flags);
+    
+    if (group_kernels.size() > 1) {
+        sort_cells_by_group();
+    }
+    
+    tile_beta_agents.resize(grid.tile_count());
+    if (publish_step) snapshot_back.resize(agents.size());
 }
 
-Vector2 FlockSimulation::compute_alpha_force(const Agent& agent) {
-    Vector2 gradient_force(0, 0);
-    Vector2 consensus_force(0, 0);
+template <int D>
+void BasicFlockSimulation<D>::sort_cells_by_group() {
+    // Сортировка вставками внутри каждой ячейки: ячейки малы, а порядок
+    // прошлого шага почти сохраняется, поэтому проход почти линейный
+    bool has_ghosts = !ghost_flags.empty();
+    size_t cell_count = grid.cell_start.size() - 1;
     
-    for (const auto& other : agents) {
-        if (&agent == &other) continue;
+    for (size_t key = 0; key < cell_count; ++key) {
+        size_t begin = grid.cell_start[key];
+        size_t end = grid.cell_start[key + 1];
         
-        Vector2 diff = other.position - agent.position;
-        double distance = diff.length();
-        
-        if (distance < params.interaction_range && distance > 0.1) {
-            // Градиентный член из уравнения (68)
-            double z = sigma_norm(diff);
-            Vector2 n_ij = sigma_epsilon(diff);
-            gradient_force = gradient_force + n_ij * phi_alpha(z);
+        for (size_t i = begin + 1; i < end; ++i) {
+            if (agents[i - 1].group <= agents[i].group) continue;
+            
+            AgentType agent = agents[i];
+            char flag = has_ghosts ? ghost_flags[i] : 0;
+            size_t j = i;
+            for (; j > begin && agents[j - 1].group > agent.group; --j) {
+                agents[j] = agents[j - 1];
+                if (has_ghosts) ghost_flags[j] = ghost_flags[j - 1];
+            }
+            agents[j] = agent;
+            if (has_ghosts) ghost_flags[j] = flag;
+        }
+    }
+}
+
+template <int D>
+template <size_t... Index>
+auto BasicFlockSimulation<D>::make_force_kernels(std::index_sequence<Index...>)
+    -> std::array<TileTask, sizeof...(Index)> {
+    return {{ &BasicFlockSimulation::compute_tile_forces<
+        StepPolicy<(Index & 8) != 0, (Index & 4) != 0, (Index & 2) != 0, (Index & 1) != 0>>... }};
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::select_force_kernel() const -> TileTask {
+    // Все сочетания режимов инстанцируются заранее; индекс - биты режимов
+    static const std::array<TileTask, 16> kernels = make_force_kernels(std::make_index_sequence<16>());
+    
+    bool any_target = false;
+    for (const auto& kernel : group_kernels) {
+        any_target = any_target || kernel.settings.has_target;
+    }
+    
+    int index = (use_gamma_target && any_target ? 8 : 0) + (obstacles.empty() ? 0 : 4) +
+                (metrics_config.enabled ? 2 : 0) + (group_kernels.size() > 1 ? 1 : 0);
+    return kernels[index];
+}
+
+template <int D>
+void BasicFlockSimulation<D>::build_step_graph() {
+    TileTask compute_forces = select_force_kernel();
+    if (compute_forces == graph_kernel && grid.tile_cols == graph_tile_cols && grid.tile_rows == graph_tile_rows) {
+        return;
+    }
+    graph_kernel = compute_forces;
+    graph_tile_cols = grid.tile_cols;
+    graph_tile_rows = grid.tile_rows;
+    
+    step_graph.clear();
+    int tiles = grid.tile_count();
+    for (int tile = 0; tile < tiles; ++tile) {
+        step_graph.add_task([this, tile] { update_beta_agents(tile); });
+        step_graph.add_task([this, tile, compute_forces] { (this->*compute_forces)(tile); });
+        step_graph.add_task([this, tile] { integrate_tile(tile); });
+    }
+    
+    // Задачи тайла t: 3t - β-агенты, 3t + 1 - силы, 3t + 2 - интегрирование.
+    // Силы тайла читают β-агентов соседей, интегрирование тайла
+    // перезаписывает позиции, которые читают силы соседей
+    for (int ty = 0; ty < grid.tile_rows; ++ty) {
+        for (int tx = 0; tx < grid.tile_cols; ++tx) {
+            int tile = ty * grid.tile_cols + tx;
             
-            // Консенсусный член (velocity matching) из уравнения (68)
-            double a_ij = alpha_adjacency(agent.position, other.position);
-            consensus_force = consensus_force + (other.velocity - agent.velocity) * a_ij;
+            for (int ny = std::max(0, ty - 1); ny <= std::min(grid.tile_rows - 1, ty + 1); ++ny) {
+                for (int nx = std::max(0, tx - 1); nx <= std::min(grid.tile_cols - 1, tx + 1); ++nx) {
+                    int neighbor = ny * grid.tile_cols + nx;
+                    step_graph.add_dependency(3 * neighbor, 3 * tile + 1);
+                    step_graph.add_dependency(3 * neighbor + 1, 3 * tile + 2);
+                }
+            }
         }
     }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::remove_ghosts() {
+    // Уплотняем агентов и снимок, сохраняя порядок собственных агентов
+    size_t kept = 0;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (ghost_flags[i]) continue;
+        agents[kept] = agents[i];
+        if (publish_step) snapshot_back[kept] = snapshot_back[i];
+        kept++;
+    }
+    agents.resize(kept);
+    if (publish_step) snapshot_back.resize(kept);
+    
+    ghost_flags.clear();
+    ghost_agents.clear();
+}
+
+template <int D>
+FlockMetrics BasicFlockSimulation<D>::reduce_metrics() {
+    MetricsAccumulator total;
+    for (const auto& partial : tile_metrics) {
+        total.merge(partial);
+    }
+    
+    FlockMetrics metrics;
+    metrics.agent_count = total.agents;
+    if (total.agents == 0) return metrics;
+    
+    // Размеры компонент: корень системы множеств - собственный агент
+    // с наименьшим индексом в компоненте
+    component_sizes.assign(agents.size(), 0);
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (!ghost_flags.empty() && ghost_flags[i]) continue;
+        uint32_t root = components.find(static_cast<uint32_t>(i));
+        if (component_sizes[root]++ == 0) metrics.components++;
+        metrics.largest_component = std::max<size_t>(metrics.largest_component, component_sizes[root]);
+    }
+    
+    double n = static_cast<double>(total.agents);
+    metrics.cohesion = metrics.largest_component / n;
+    metrics.mean_degree = total.edges / n;
+    
+    // Каждая пара посчитана обоими агентами
+    metrics.potential_energy = 0.5 * total.potential;
+    metrics.collisions = total.collisions / 2;
+    metrics.kinetic_energy = total.kinetic;
+    
+    double mean_speed_squared = 0.0;
+    for (int axis = 0; axis < D; ++axis) {
+        double mean = total.velocity[axis] / n;
+        mean_speed_squared += mean * mean;
+    }
+    double mismatch = total.speed_squared / n - mean_speed_squared;
+    metrics.velocity_mismatch = std::sqrt(std::max(0.0, mismatch));
     
-    return gradient_force * params.c1_alpha + consensus_force * params.c2_alpha;
+    if (total.neighbor_agents > 0) {
+        metrics.neighbor_deviation = total.deviation / total.neighbor_agents;
+    }
+    return metrics;
 }
 
-Vector2 FlockSimulation::compute_beta_force(const Agent& agent) {
-    Vector2 repulsion_force(0, 0);
-    Vector2 damping_force(0, 0);
+template <int D>
+template <class Policy>
+void BasicFlockSimulation<D>::compute_tile_forces(int tile) {
+    MetricsAccumulator* metrics = Policy::with_metrics ? &tile_metrics[tile] : nullptr;
+    size_t end = grid.tile_end(tile);
     
-    for (const auto& beta_agent : beta_agents) {
-        Vector2 diff = beta_agent.position - agent.position;
-        double distance = diff.length();
+    // Агенты ячейки отсортированы по группам: константы группы берутся
+    // один раз на серию агентов одной группы
+    for (size_t i = grid.tile_begin(tile); i < end;) {
+        uint32_t group = Policy::with_groups ? agents[i].group : 0;
+        const GroupKernel& kernel = group_kernels[group];
+        
+        size_t run_end = end;
+        if constexpr (Policy::with_groups) {
+            run_end = i + 1;
+            while (run_end < end && agents[run_end].group == group) ++run_end;
+        }
+        bool run_has_target = Policy::with_target && kernel.settings.has_target;
         
-        if (distance < params.obstacle_range && distance > 0.1) {
-            // Отталкивающий член из уравнения (69)
-            double z = sigma_norm(diff);
-            Vector2 n_ik = sigma_epsilon(diff);
-            repulsion_force = repulsion_force + n_ik * phi_beta(z);
+        // Обновляем ускорения для агентов серии согласно Algorithm 3
+        for (; i < run_end; ++i) {
+            if (!ghost_flags.empty() && ghost_flags[i]) continue; // призраки не интегрируются
+            
+            AgentType& agent = agents[i];
+            
+            // Суммируем все силы согласно уравнению (67); отключенные
+            // режимы не попадают в инстанцию ядра
+            Vec force = compute_alpha_force<Policy::with_metrics, Policy::with_groups>(agent, i, kernel, metrics);
+            if constexpr (Policy::with_obstacles) {
+                force = force + compute_beta_force(agent, kernel);
+            }
+            if constexpr (Policy::with_target) {
+                if (run_has_target) force = force + compute_gamma_force(agent, kernel);
+            }
             
-            // Демпфирующий член из уравнения (69)
-            double b_ik = beta_adjacency(agent.position, beta_agent.position);
-            damping_force = damping_force + (beta_agent.velocity - agent.velocity) * b_ik;
+            agent.acceleration = force;
+        }
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::integrate_tile(int tile) {
+    for (size_t i = grid.tile_begin(tile); i < grid.tile_end(tile); ++i) {
+        if (!ghost_flags.empty() && ghost_flags[i]) continue;
+        
+        integrate_agent(agents[i], step_dt);
+        if (publish_step) snapshot_back[i] = agents[i];
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::integrate_agent(AgentType& agent, double delta_time) const {
+    // Интегрирование скорости (уравнение движения (2))
+    agent.velocity = agent.velocity + agent.acceleration * delta_time;
+    
+    // Ограничение максимальной скорости для стабильности
+    double speed = agent.velocity.length();
+    if (speed > MAX_AGENT_SPEED) {
+        agent.velocity = agent.velocity.normalized() * MAX_AGENT_SPEED;
+    }
+    
+    // Интегрирование позиции
+    agent.position = agent.position + agent.velocity * delta_time;
+    
+    // Мягкое ограничение области. За жесткой границей прежняя формула
+    // меняла знак и выталкивала агентов наружу, поэтому там толчок полный
+    const double boundary = world_bound;
+    const double soft_boundary = 0.9 * world_bound;
+    
+    for (int axis = 0; axis < D; ++axis) {
+        double coordinate = agent.position[axis];
+        if (std::abs(coordinate) > soft_boundary) {
+            double push = std::abs(coordinate) < boundary
+                ? (boundary - std::abs(coordinate)) / (boundary - soft_boundary)
+                : 1.0;
+            agent.velocity[axis] += (coordinate > 0 ? -1 : 1) * push * 5.0;
         }
     }
+}
+
+template <int D>
+template <bool WithMetrics, bool WithGroups>
+auto BasicFlockSimulation<D>::compute_alpha_force(const AgentType& agent, size_t index, const GroupKernel& kernel,
+                                                  MetricsAccumulator* metrics) -> Vec {
+    const Parameters& group_params = kernel.settings.params;
+    Vec gradient_force;
+    Vec consensus_force;
+    double nearest = group_params.interaction_range;
+    size_t neighbors = 0;
+    
+    // Корень компоненты агента: пары, уже лежащие в ней, не объединяются заново.
+    // Устаревший корень лишь приводит к лишнему unite, а не к ошибке
+    uint32_t root = 0;
+    bool with_potential = false;
+    if constexpr (WithMetrics) {
+        root = components.find(static_cast<uint32_t>(index));
+        with_potential = metrics_config.potential_energy;
+    }
     
-    return repulsion_force * params.c1_beta + damping_force * params.c2_beta;
+    // Соседи по радиусу r лежат только в соседних ячейках
+    int cx = grid.cell_x(agent.position.x);
+    int cy = grid.cell_y(agent.position.y);
+    int cz = grid.cell_z(agent.position);
+    
+    for (int nz = std::max(0, cz - 1); nz <= std::min(grid.layers - 1, cz + 1); ++nz) {
+        for (int ny = std::max(0, cy - 1); ny <= std::min(grid.rows - 1, cy + 1); ++ny) {
+            for (int nx = std::max(0, cx - 1); nx <= std::min(grid.cols - 1, cx + 1); ++nx) {
+                int key = grid.cell_key(nx, ny, nz);
+                
+                for (size_t j = grid.cell_start[key]; j < grid.cell_start[key + 1]; ++j) {
+                    if (j == index) continue;
+                    const AgentType& other = agents[j];
+                    
+                    Vec diff = other.position - agent.position;
+                    double distance = diff.length();
+                    if (distance >= group_params.interaction_range) continue;
+                    
+                    bool counted = WithMetrics && (ghost_flags.empty() || !ghost_flags[j]);
+                    if constexpr (WithMetrics) {
+                        // Столкновения считаются между любыми группами
+                        if (counted && distance < metrics_config.collision_distance) metrics->collisions++;
+                    }
+                    
+                    // Правило группы агента для чужих: полное взаимодействие,
+                    // только отталкивание или ничего
+                    bool full_interaction = true;
+                    if constexpr (WithGroups) {
+                        if (other.group != agent.group) {
+                            if (kernel.settings.cross_group == CrossGroupRule::Ignore) continue;
+                            full_interaction = kernel.settings.cross_group == CrossGroupRule::Flock;
+                        }
+                    }
+                    
+                    double z = sigma_norm(diff, group_params.epsilon);
+                    
+                    // Метрики по той же паре; ребра с призраками в граф не входят,
+                    // ребро - только пара с полным взаимодействием
+                    if constexpr (WithMetrics) {
+                        if (counted && full_interaction) {
+                            if (with_potential) metrics->potential += psi_alpha(z, kernel);
+                            metrics->edges++;
+                            // При несимметричных правилах групп пара может
+                            // быть ребром только с одной стороны
+                            if ((j > index || other.group != agent.group) &&
+                                components.find(static_cast<uint32_t>(j)) != root) {
+                                components.unite(static_cast<uint32_t>(index), static_cast<uint32_t>(j));
+                                root = components.find(static_cast<uint32_t>(index));
+                            }
+                            nearest = std::min(nearest, distance);
+                            neighbors++;
+                        }
+                    }
+                    
+                    if (distance > 0.1) {
+                        // Градиентный член из уравнения (68); для чужих групп
+                        // при правиле Separate - только отталкивающая часть
+                        double phi = phi_alpha(z, kernel);
+                        if (full_interaction || phi < 0.0) {
+                            gradient_force = gradient_force + sigma_epsilon(diff, group_params.epsilon) * phi;
+                        }
+                        
+                        // Консенсусный член (velocity matching) из уравнения (68),
+                        // a_ij = ρ_h(||q_j - q_i||_σ / r_α)
+                        if (full_interaction) {
+                            double a_ij = bump_function(z / kernel.r_alpha, group_params.h_alpha);
+                            consensus_force = consensus_force + (other.velocity - agent.velocity) * a_ij;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    if constexpr (WithMetrics) {
+        double speed_squared = agent.velocity.dot(agent.velocity);
+        metrics->agents++;
+        metrics->kinetic += 0.5 * speed_squared;
+        metrics->speed_squared += speed_squared;
+        for (int axis = 0; axis < D; ++axis) {
+            metrics->velocity[axis] += agent.velocity[axis];
+        }
+        if (neighbors > 0) {
+            metrics->deviation += std::abs(nearest - group_params.desired_distance) / group_params.desired_distance;
+            metrics->neighbor_agents++;
+        }
+    }
+    
+    return gradient_force * group_params.c1_alpha + consensus_force * group_params.c2_alpha;
 }
 
-Vector2 FlockSimulation::compute_gamma_force(const Agent& agent) {
-    if (!use_gamma_target) return Vector2(0, 0);
+template <int D>
+auto BasicFlockSimulation<D>::compute_beta_force(const AgentType& agent, const GroupKernel& kernel) -> Vec {
+    const Parameters& group_params = kernel.settings.params;
+    Vec repulsion_force;
+    Vec damping_force;
+    
+    // β-агенты в радиусе r' порождены агентами соседних тайлов
+    int tx = grid.cell_x(agent.position.x) / grid.tile_span;
+    int ty = grid.cell_y(agent.position.y) / grid.tile_span;
+    
+    for (int ny = std::max(0, ty - 1); ny <= std::min(grid.tile_rows - 1, ty + 1); ++ny) {
+        for (int nx = std::max(0, tx - 1); nx <= std::min(grid.tile_cols - 1, tx + 1); ++nx) {
+            for (const auto& beta_agent : tile_beta_agents[ny * grid.tile_cols + nx]) {
+                Vec diff = beta_agent.position - agent.position;
+                double distance = diff.length();
+                
+                if (distance < group_params.obstacle_range && distance > 0.1) {
+                    // Отталкивающий член из уравнения (69)
+                    double z = sigma_norm(diff, group_params.epsilon);
+                    Vec n_ik = sigma_epsilon(diff, group_params.epsilon);
+                    repulsion_force = repulsion_force + n_ik * phi_beta(z, kernel);
+                    
+                    // Демпфирующий член из уравнения (69), b_ik = ρ_h(||q̂_k - q_i||_σ / d_β)
+                    double b_ik = bump_function(z / kernel.d_beta, group_params.h_beta);
+                    damping_force = damping_force + (beta_agent.velocity - agent.velocity) * b_ik;
+                }
+            }
+        }
+    }
     
-    Vector2 diff = agent.position - gamma_target;
+    return repulsion_force * group_params.c1_beta + damping_force * group_params.c2_beta;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::compute_gamma_force(const AgentType& agent, const GroupKernel& kernel) -> Vec {
+    const Parameters& group_params = kernel.settings.params;
+    Vec diff = agent.position - kernel.settings.target;
     double norm_diff = diff.length();
     
     // Правильная σ_1 по уравнению (70)
-    Vector2 position_term = (norm_diff < 1e-10) ? 
-        Vector2(0,0) : diff * (1.0 / std::sqrt(1.0 + norm_diff * norm_diff));
+    Vec position_term = (norm_diff < 1e-10) ?
+        Vec() : diff * (1.0 / std::sqrt(1.0 + norm_diff * norm_diff));
     
-    Vector2 velocity_term = agent.velocity - gamma_velocity;
+    Vec velocity_term = agent.velocity - kernel.settings.target_velocity;
     
-    return position_term * (-params.c1_gamma) - velocity_term * params.c2_gamma;
+    return position_term * (-group_params.c1_gamma) - velocity_term * group_params.c2_gamma;
 }
 
-void FlockSimulation::update_beta_agents() {
-    beta_agents.clear();
+template <int D>
+void BasicFlockSimulation<D>::update_beta_agents(int tile) {
+    std::vector<BetaAgentType>& tile_betas = tile_beta_agents[tile];
+    tile_betas.clear();
+    if (obstacles.empty()) return;
     
-    // Для каждого агента проверяем близкие препятствия и создаем β-агентов
-    for (const auto& agent : agents) {
-        for (const auto& obstacle : obstacles) {
-            Vector2 to_obstacle = obstacle.position - agent.position;
+    // Для каждого агента тайла проверяем близкие препятствия и создаем β-агентов
+    for (size_t i = grid.tile_begin(tile); i < grid.tile_end(tile); ++i) {
+        const AgentType& agent = agents[i];
+        const std::vector<int>* candidates = obstacle_grid.query(planar(agent.position));
+        if (!candidates) continue;
+        
+        for (int index : *candidates) {
+            const ObstacleType& obstacle = obstacles[index];
+            Vec to_obstacle = obstacle.position - agent.position;
             double distance = to_obstacle.length();
             
-            if (distance < params.obstacle_range + obstacle.radius) {
-                BetaAgent beta_agent = project_to_obstacle(agent, obstacle);
-                beta_agents.push_back(beta_agent);
+            if (distance < group_kernels[agent.group].settings.params.obstacle_range + obstacle.radius) {
+                BetaAgentType beta_agent = project_to_obstacle(agent, obstacle);
+                tile_betas.push_back(beta_agent);
             }
         }
     }
 }
 
-BetaAgent FlockSimulation::project_to_obstacle(const Agent& agent, const Obstacle& obstacle) const {
-    BetaAgent beta_agent;
+template <int D>
+auto BasicFlockSimulation<D>::project_to_obstacle(const AgentType& agent, const ObstacleType& obstacle) const
+    -> BetaAgentType {
+    BetaAgentType beta_agent;
     
     if (obstacle.is_wall) {
-        // Проекция на стену (гиперплоскость)
-        // Упрощенная версия - предполагаем горизонтальную/вертикальную стену
-        if (std::abs(obstacle.position.x - agent.position.x) < std::abs(obstacle.position.y - agent.position.y)) {
-            // Горизонтальная стена
-            beta_agent.position = Vector2(agent.position.x, obstacle.position.y);
-            beta_agent.velocity = Vector2(agent.velocity.x, 0); // скорость параллельна стене
-        } else {
-            // Вертикальная стена  
-            beta_agent.position = Vector2(obstacle.position.x, agent.position.y);
-            beta_agent.velocity = Vector2(0, agent.velocity.y);
-        }
+        // Проекция на стену (гиперплоскость с нормалью wall_normal):
+        // нормальная составляющая скорости - от стены, касательная - от агента
+        Vec normal = obstacle.wall_normal.normalized();
+        beta_agent.position = agent.position - normal * normal.dot(agent.position - obstacle.position);
+        beta_agent.velocity = agent.velocity - normal * normal.dot(agent.velocity - obstacle.velocity);
     } else {
         // Проекция на сферическое препятствие
-        Vector2 to_center = obstacle.position - agent.position;
+        Vec to_center = obstacle.position - agent.position;
         double distance_to_center = to_center.length();
         double mu = obstacle.radius / distance_to_center;
         if (distance_to_center > 0.1) {
-            Vector2 direction = to_center.normalized();
+            Vec direction = to_center.normalized();
             beta_agent.position = obstacle.position - direction * obstacle.radius;
-            // Проекция скорости на касательную плоскость
-            beta_agent.velocity = (agent.velocity - direction * agent.velocity.dot(direction)) * mu;
+            // Проекция относительной скорости на касательную плоскость
+            // плюс переносная скорость самого препятствия
+            Vec relative = agent.velocity - obstacle.velocity;
+            beta_agent.velocity = obstacle.velocity + (relative - direction * relative.dot(direction)) * mu;
         } else {
-            beta_agent.position = obstacle.position + Vector2(obstacle.radius, 0);
-            beta_agent.velocity = Vector2(0, 0);
+            beta_agent.position = obstacle.position + Vec(obstacle.radius, 0);
+            beta_agent.velocity = obstacle.velocity;
         }
     }
     
     return beta_agent;
 }
 
-void FlockSimulation::add_obstacle(const Vector2& position, double radius) {
+template <int D>
+void BasicFlockSimulation<D>::add_obstacle(const Vec& position, double radius) {
     std::lock_guard<std::mutex> lock(data_mutex);
     obstacles.emplace_back(position, radius, false); // сферическое препятствие
-    std::cout << "Added obstacle at (" << position.x << ", " << position.y 
-              << ") with radius " << radius << std::endl;
+    obstacle_grid.insert(static_cast<int>(obstacles.size() - 1), planar(position), radius + max_obstacle_range);
+    if (verbose) std::cout << "Added obstacle at " << position
+              << " with radius " << radius << std::endl;
 }
 
-void FlockSimulation::set_target(const Vector2& target) {
+template <int D>
+void BasicFlockSimulation<D>::add_moving_obstacle(const Vec& position, const Vec& velocity, double radius) {
     std::lock_guard<std::mutex> lock(data_mutex);
-    gamma_target = target;
+    obstacles.emplace_back(position, radius, false);
+    obstacles.back().velocity = velocity;
+    obstacles.back().trajectory.type = TrajectoryType::Linear;
+    obstacle_grid.insert(static_cast<int>(obstacles.size() - 1), planar(position), radius + max_obstacle_range);
+    if (verbose) std::cout << "Added moving obstacle at " << position
+              << " with velocity " << velocity << std::endl;
+}
+
+// Единичный вектор в плоскости x-y и касательная к нему (поворот на 90°)
+template <int D>
+static VecN<D> planar_direction(double angle) {
+    VecN<D> direction;
+    direction.x = std::cos(angle);
+    direction.y = std::sin(angle);
+    return direction;
+}
+
+template <int D>
+static VecN<D> planar_tangent(double angle) {
+    VecN<D> tangent;
+    tangent.x = -std::sin(angle);
+    tangent.y = std::cos(angle);
+    return tangent;
+}
+
+template <int D>
+void BasicFlockSimulation<D>::add_orbiting_obstacle(const Vec& center, double orbit_radius, double angular_speed,
+                                                    double radius, double phase) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    BasicObstacleTrajectory<D> trajectory;
+    trajectory.type = TrajectoryType::Orbit;
+    trajectory.center = center;
+    trajectory.orbit_radius = orbit_radius;
+    trajectory.angular_speed = angular_speed;
+    // Фаза отсчитывается от текущего времени, чтобы препятствие стартовало в заданной точке орбиты
+    trajectory.phase = phase - angular_speed * simulation_time;
+    
+    Vec position = center + planar_direction<D>(phase) * orbit_radius;
+    obstacles.emplace_back(position, radius, false);
+    obstacles.back().velocity = planar_tangent<D>(phase) * (orbit_radius * angular_speed);
+    obstacles.back().trajectory = trajectory;
+    obstacle_grid.insert(static_cast<int>(obstacles.size() - 1), planar(position), radius + max_obstacle_range);
+    if (verbose) std::cout << "Added orbiting obstacle around " << center
+              << " with orbit radius " << orbit_radius << std::endl;
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_obstacle_velocity(size_t index, const Vec& velocity) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    if (index >= obstacles.size()) return;
+    
+    // Заданная вручную скорость переводит препятствие в линейное движение
+    obstacles[index].velocity = velocity;
+    obstacles[index].trajectory.type = TrajectoryType::Linear;
+}
+
+template <int D>
+void BasicFlockSimulation<D>::move_obstacles(double delta_time) {
+    simulation_time += delta_time;
+    const double boundary = world_bound;
+    
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+        ObstacleType& obstacle = obstacles[i];
+        const BasicObstacleTrajectory<D>& trajectory = obstacle.trajectory;
+        
+        switch (trajectory.type) {
+            case TrajectoryType::Static:
+                continue;
+            
+            case TrajectoryType::Linear:
+                obstacle.position = obstacle.position + obstacle.velocity * delta_time;
+                
+                // Отражение от границы области
+                for (int axis = 0; axis < D; ++axis) {
+                    if (std::abs(obstacle.position[axis]) > boundary &&
+                        obstacle.position[axis] * obstacle.velocity[axis] > 0) {
+                        obstacle.velocity[axis] = -obstacle.velocity[axis];
+                    }
+                }
+                break;
+            
+            case TrajectoryType::Orbit: {
+                double angle = trajectory.phase + trajectory.angular_speed * simulation_time;
+                obstacle.position = trajectory.center + planar_direction<D>(angle) * trajectory.orbit_radius;
+                obstacle.velocity = planar_tangent<D>(angle) * (trajectory.orbit_radius * trajectory.angular_speed);
+                break;
+            }
+        }
+        
+        obstacle_grid.refit(static_cast<int>(i), planar(obstacle.position), obstacle.radius + max_obstacle_range);
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::rebuild_obstacle_grid() {
+    obstacle_grid.clear();
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+        obstacle_grid.insert(static_cast<int>(i), planar(obstacles[i].position), obstacles[i].radius + max_obstacle_range);
+    }
+}
+
+void ObstacleGrid::clear() {
+    ranges.clear();
+    cells.clear();
+}
+
+ObstacleGrid::CellRange ObstacleGrid::compute_range(const Vector2& center, double extent) const {
+    return CellRange{
+        cell_coord(center.x - extent), cell_coord(center.y - extent),
+        cell_coord(center.x + extent), cell_coord(center.y + extent)
+    };
+}
+
+void ObstacleGrid::insert(int index, const Vector2& center, double extent) {
+    if (ranges.size() <= static_cast<size_t>(index)) {
+        ranges.resize(index + 1, CellRange{0, 0, -1, -1}); // пустой диапазон
+    }
+    
+    CellRange range = compute_range(center, extent);
+    for (int cy = range.min_y; cy <= range.max_y; ++cy) {
+        for (int cx = range.min_x; cx <= range.max_x; ++cx) {
+            add_to_cell(index, cx, cy);
+        }
+    }
+    ranges[index] = range;
+}
+
+void ObstacleGrid::refit(int index, const Vector2& center, double extent) {
+    CellRange old_range = ranges[index];
+    CellRange new_range = compute_range(center, extent);
+    if (new_range == old_range) return; // препятствие осталось в тех же ячейках
+    
+    for (int cy = old_range.min_y; cy <= old_range.max_y; ++cy) {
+        for (int cx = old_range.min_x; cx <= old_range.max_x; ++cx) {
+            if (!new_range.contains(cx, cy)) remove_from_cell(index, cx, cy);
+        }
+    }
+    for (int cy = new_range.min_y; cy <= new_range.max_y; ++cy) {
+        for (int cx = new_range.min_x; cx <= new_range.max_x; ++cx) {
+            if (!old_range.contains(cx, cy)) add_to_cell(index, cx, cy);
+        }
+    }
+    ranges[index] = new_range;
+}
+
+const std::vector<int>* ObstacleGrid::query(const Vector2& point) const {
+    auto it = cells.find(cell_id(cell_coord(point.x), cell_coord(point.y)));
+    return it == cells.end() ? nullptr : &it->second;
+}
+
+void ObstacleGrid::add_to_cell(int index, int cx, int cy) {
+    cells[cell_id(cx, cy)].push_back(index);
+}
+
+void ObstacleGrid::remove_from_cell(int index, int cx, int cy) {
+    auto it = cells.find(cell_id(cx, cy));
+    if (it == cells.end()) return;
+    
+    std::vector<int>& list = it->second;
+    auto pos = std::find(list.begin(), list.end(), index);
+    if (pos != list.end()) {
+        *pos = list.back();
+        list.pop_back();
+    }
+    if (list.empty()) cells.erase(it);
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_target(const Vec& target) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    group_kernels[0].settings.target = target;
+    group_kernels[0].settings.has_target = true;
     use_gamma_target = true; // Автоматически включаем цель при установке
-    std::cout << "Target set to (" << target.x << ", " << target.y << ")" << std::endl;
+    if (verbose) std::cout << "Target set to " << target << std::endl;
 }
 
-void FlockSimulation::clear_obstacles() {
+template <int D>
+void BasicFlockSimulation<D>::clear_obstacles() {
     std::lock_guard<std::mutex> lock(data_mutex);
     obstacles.clear();
+    obstacle_grid.clear();
     beta_agents.clear();
-    std::cout << "All obstacles cleared" << std::endl;
+    for (auto& tile_betas : tile_beta_agents) {
+        tile_betas.clear();
+    }
+    if (verbose) std::cout << "All obstacles cleared" << std::endl;
 }
 
-std::vector<Agent> FlockSimulation::get_agents() const{
+template <int D>
+uint32_t BasicFlockSimulation<D>::add_group(const GroupType& group) {
     std::lock_guard<std::mutex> lock(data_mutex);
-    return agents;
+    group_kernels.push_back(make_group_kernel(group));
+    update_group_ranges();
+    return static_cast<uint32_t>(group_kernels.size() - 1);
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_group(uint32_t group, const GroupType& settings) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    if (group >= group_kernels.size()) return;
+    
+    group_kernels[group] = make_group_kernel(settings);
+    if (group == 0) params = settings.params;
+    update_group_ranges();
 }
 
-std::vector<Obstacle> FlockSimulation::get_obstacles() const{
+template <int D>
+void BasicFlockSimulation<D>::set_group_target(uint32_t group, const Vec& target, const Vec& velocity) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    if (group >= group_kernels.size()) return;
+    
+    // Цель меняется часто, константы ядра при этом не пересчитываются
+    GroupType& settings = group_kernels[group].settings;
+    settings.target = target;
+    settings.target_velocity = velocity;
+    settings.has_target = true;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::get_group(uint32_t group) const -> GroupType {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return group < group_kernels.size() ? group_kernels[group].settings : GroupType();
+}
+
+template <int D>
+size_t BasicFlockSimulation<D>::get_group_count() const {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return group_kernels.size();
+}
+
+template <int D>
+void BasicFlockSimulation<D>::assign_groups(const std::function<uint32_t(const AgentType&)>& classify) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    // Неизвестная группа заменяется группой 0; порядок по группам
+    // восстановится при сортировке следующего шага
+    for (auto& agent : agents) {
+        uint32_t group = classify(agent);
+        agent.group = group < group_kernels.size() ? group : 0;
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_metrics_config(const MetricsConfig& config) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    metrics_config = config;
+    
+    std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
+    if (!metrics_config.enabled) {
+        metrics_history.clear();
+    }
+    while (metrics_config.history_limit > 0 && metrics_history.size() > metrics_config.history_limit) {
+        metrics_history.pop_front();
+    }
+}
+
+template <int D>
+FlockMetrics BasicFlockSimulation<D>::get_metrics() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    return latest_metrics;
+}
+
+template <int D>
+std::vector<FlockMetrics> BasicFlockSimulation<D>::get_metrics_history() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    return std::vector<FlockMetrics>(metrics_history.begin(), metrics_history.end());
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_step_observer(Observer observer) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    step_observer = std::move(observer);
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_ghost_agents(std::vector<AgentType> ghosts) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    ghost_agents = std::move(ghosts);
+    for (auto& agent : ghost_agents) {
+        if (agent.group >= group_kernels.size()) agent.group = 0;
+    }
+}
+
+template <int D>
+void BasicFlockSimulation<D>::add_agents(const std::vector<AgentType>& new_agents) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    // Снимок для рендеринга обновится на следующем шаге
+    size_t first = agents.size();
+    agents.insert(agents.end(), new_agents.begin(), new_agents.end());
+    for (size_t i = first; i < agents.size(); ++i) {
+        if (agents[i].group >= group_kernels.size()) agents[i].group = 0;
+    }
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::extract_agents(const std::function<bool(const AgentType&)>& predicate)
+    -> std::vector<AgentType> {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    std::vector<AgentType> extracted;
+    
+    size_t kept = 0;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (predicate(agents[i])) {
+            extracted.push_back(agents[i]);
+        } else {
+            agents[kept++] = agents[i];
+        }
+    }
+    agents.resize(kept);
+    
+    return extracted;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::copy_agents(const std::function<bool(const AgentType&)>& predicate) const
+    -> std::vector<AgentType> {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    std::vector<AgentType> copied;
+    for (const auto& agent : agents) {
+        if (predicate(agent)) copied.push_back(agent);
+    }
+    return copied;
+}
+
+template <int D>
+size_t BasicFlockSimulation<D>::get_agent_count() const {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return agents.size();
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::get_agents_in_region(const Vec& min_corner, const Vec& max_corner) const
+    -> std::vector<AgentType> {
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    std::vector<AgentType> visible;
+    
+    auto inside = [&](const AgentType& agent) {
+        for (int axis = 0; axis < D; ++axis) {
+            if (agent.position[axis] < min_corner[axis] || agent.position[axis] > max_corner[axis]) return false;
+        }
+        return true;
+    };
+    
+    // Пустая сетка (cols == 0) не покрывает снимок: перебираем его целиком
+    bool grid_usable = snapshot_grid_valid && snapshot_grid.cols > 0 && snapshot_grid.cell_start.size() > 1;
+    if (!grid_usable || agents_snapshot.empty()) {
+        for (const auto& agent : agents_snapshot) {
+            if (inside(agent)) visible.push_back(agent);
+        }
+        return visible;
+    }
+    
+    // Перебираем только ячейки, пересекающие расширенную на смещение область
+    const Grid& cells = snapshot_grid;
+    double margin = snapshot_grid_margin;
+    Vec padding;
+    for (int axis = 0; axis < D; ++axis) padding[axis] = margin;
+    Vec low = min_corner - padding, high = max_corner + padding;
+    
+    int cx0 = cells.cell_x(low.x), cx1 = cells.cell_x(high.x);
+    int cy0 = cells.cell_y(low.y), cy1 = cells.cell_y(high.y);
+    int cz0 = cells.cell_z(low), cz1 = cells.cell_z(high);
+    
+    for (int cz = cz0; cz <= cz1; ++cz) {
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                int key = cells.cell_key(cx, cy, cz);
+                for (size_t i = cells.cell_start[key]; i < cells.cell_start[key + 1]; ++i) {
+                    if (inside(agents_snapshot[i])) visible.push_back(agents_snapshot[i]);
+                }
+            }
+        }
+    }
+    return visible;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::get_agents() const -> std::vector<AgentType> {
+    // Опубликованный снимок не ждет завершения текущего шага
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    return agents_snapshot;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::get_obstacles() const -> std::vector<ObstacleType> {
     std::lock_guard<std::mutex> lock(data_mutex);
     return obstacles;
 }
 
-std::vector<BetaAgent> FlockSimulation::get_beta_agents() const{
+template <int D>
+auto BasicFlockSimulation<D>::get_beta_agents() const -> std::vector<BetaAgentType> {
     std::lock_guard<std::mutex> lock(data_mutex);
     return beta_agents;
 }
 
-Vector2 FlockSimulation::get_target() const{
+template <int D>
+double BasicFlockSimulation<D>::get_interaction_range() const {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return max_interaction_range;
+}
+
+template <int D>
+double BasicFlockSimulation<D>::get_obstacle_range() const {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return max_obstacle_range;
+}
+
+template <int D>
+void BasicFlockSimulation<D>::set_world_bound(double bound) {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    world_bound = bound;
+}
+
+template <int D>
+double BasicFlockSimulation<D>::get_world_bound() const {
     std::lock_guard<std::mutex> lock(data_mutex);
-    return gamma_target;
-}
\ No newline at end of file
+    return world_bound;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::get_target() const -> Vec {
+    std::lock_guard<std::mutex> lock(data_mutex);
+    return group_kernels[0].settings.target;
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::view_agents() const -> AgentsView {
+    std::unique_lock<std::mutex> lock(snapshot_mutex);
+    Span<AgentType> view(agents_snapshot);
+    return AgentsView{std::move(lock), view};
+}
+
+template <int D>
+auto BasicFlockSimulation<D>::view_state() const -> StateView {
+    // Порядок блокировок как в step: сначала данные, затем снимок
+    std::unique_lock<std::mutex> lock(data_mutex);
+    std::unique_lock<std::mutex> snapshot_lock(snapshot_mutex);
+    return StateView{std::move(lock), std::move(snapshot_lock), Span<AgentType>(agents_snapshot),
+                     Span<ObstacleType>(obstacles), Span<BetaAgentType>(beta_agents),
+                     group_kernels[0].settings.target, max_interaction_range, max_obstacle_range};
+}
+
+template class BasicFlockSimulation<2>;
+template class BasicFlockSimulation<3>;
@@ -1,30 +1,44 @@
 #pragma once
 #include <vector>
+#include <array>
+#include <algorithm>
 #include <cmath>
 #include <atomic>
 #include <mutex>
 #include <iostream>
 #include <random>
+#include <unordered_map>
+#include <functional>
+#include <deque>
+#include <cstdint>
+#include <utility>
+#include "task_scheduler.h"
+#include "flock_metrics.h"
+#include "span.h"
+
+// Вектор размерности D. 2D и 3D заданы явно, чтобы сохранить поля x, y, z
+// и не платить в 2D за циклы по осям.
+template <int D> struct VecN;
 
 // Простой класс вектора для 2D
-struct Vector2 {
+template <> struct VecN<2> {
     double x, y;
     
-    Vector2(double x = 0, double y = 0) : x(x), y(y) {}
+    VecN(double x = 0, double y = 0) : x(x), y(y) {}
     
-    Vector2 operator+(const Vector2& other) const {
-        return Vector2(x + other.x, y + other.y);
+    VecN operator+(const VecN& other) const {
+        return VecN(x + other.x, y + other.y);
     }
     
-    Vector2 operator-(const Vector2& other) const {
-        return Vector2(x - other.x, y - other.y);
+    VecN operator-(const VecN& other) const {
+        return VecN(x - other.x, y - other.y);
     }
     
-    Vector2 operator*(double scalar) const {
-        return Vector2(x * scalar, y * scalar);
+    VecN operator*(double scalar) const {
+        return VecN(x * scalar, y * scalar);
     }
     
-    double dot(const Vector2& other) const {
+    double dot(const VecN& other) const {
         return x * other.x + y * other.y;
     }
     
@@ -32,99 +46,438 @@ struct Vector2 {
         return std::sqrt(x*x + y*y);
     }
     
-    Vector2 normalized() const {
+    VecN normalized() const {
+        double len = length();
+        if (len < 1e-10) return VecN(0, 0);
+        return VecN(x/len, y/len);
+    }
+    
+    double operator[](int axis) const { return axis == 0 ? x : y; }
+    double& operator[](int axis) { return axis == 0 ? x : y; }
+};
+
+// Вектор для 3D (рои дронов)
+template <> struct VecN<3> {
+    double x, y, z;
+    
+    VecN(double x = 0, double y = 0, double z = 0) : x(x), y(y), z(z) {}
+    
+    VecN operator+(const VecN& other) const {
+        return VecN(x + other.x, y + other.y, z + other.z);
+    }
+    
+    VecN operator-(const VecN& other) const {
+        return VecN(x - other.x, y - other.y, z - other.z);
+    }
+    
+    VecN operator*(double scalar) const {
+        return VecN(x * scalar, y * scalar, z * scalar);
+    }
+    
+    double dot(const VecN& other) const {
+        return x * other.x + y * other.y + z * other.z;
+    }
+    
+    double length() const {
+        return std::sqrt(x*x + y*y + z*z);
+    }
+    
+    VecN normalized() const {
         double len = length();
-        if (len < 1e-10) return Vector2(0, 0);
-        return Vector2(x/len, y/len);
+        if (len < 1e-10) return VecN(0, 0, 0);
+        return VecN(x/len, y/len, z/len);
     }
+    
+    double operator[](int axis) const { return axis == 0 ? x : (axis == 1 ? y : z); }
+    double& operator[](int axis) { return axis == 0 ? x : (axis == 1 ? y : z); }
 };
 
+using Vector2 = VecN<2>;
+using Vector3 = VecN<3>;
+
+// Проекция на плоскость x-y: по ней строятся тайлы и хеш-сетка препятствий
+inline Vector2 planar(const Vector2& v) { return v; }
+inline Vector2 planar(const Vector3& v) { return Vector2(v.x, v.y); }
+
+inline std::ostream& operator<<(std::ostream& out, const Vector2& v) {
+    return out << "(" << v.x << ", " << v.y << ")";
+}
+
+inline std::ostream& operator<<(std::ostream& out, const Vector3& v) {
+    return out << "(" << v.x << ", " << v.y << ", " << v.z << ")";
+}
+
 // α-агент
-struct Agent {
-    Vector2 position;
-    Vector2 velocity;
-    Vector2 acceleration;
+template <int D>
+struct BasicAgent {
+    VecN<D> position;
+    VecN<D> velocity;
+    VecN<D> acceleration;
+    uint32_t group = 0; // индекс группы (стаи) агента
+    uint32_t id = 0;    // постоянный номер: порядок агентов меняется каждый шаг
     
-    Agent(Vector2 pos = Vector2(0, 0)) : position(pos), velocity(0, 0), acceleration(0, 0) {}
+    BasicAgent(VecN<D> pos = VecN<D>(), uint32_t group = 0, uint32_t id = 0)
+        : position(pos), velocity(), acceleration(), group(group), id(id) {}
 };
 
 // β-агент (препятствие)
-struct BetaAgent {
-    Vector2 position;
-    Vector2 velocity;
+template <int D>
+struct BasicBetaAgent {
+    VecN<D> position;
+    VecN<D> velocity;
     
-    BetaAgent(Vector2 pos = Vector2(0, 0)) : position(pos), velocity(0, 0) {}
+    BasicBetaAgent(VecN<D> pos = VecN<D>()) : position(pos), velocity() {}
+};
+
+// Сценарий движения препятствия
+enum class TrajectoryType { Static, Linear, Orbit };
+
+template <int D>
+struct BasicObstacleTrajectory {
+    using Type = TrajectoryType;
+    
+    Type type = Type::Static;
+    VecN<D> center;            // центр орбиты; орбита лежит в плоскости x-y
+    double orbit_radius = 0.0;
+    double angular_speed = 0.0; // рад/с, знак задает направление
+    double phase = 0.0;
 };
 
 // Препятствие
-struct Obstacle {
-    Vector2 position;
+template <int D>
+struct BasicObstacle {
+    VecN<D> position;
+    VecN<D> velocity; // скорость движущегося препятствия
     double radius;
     bool is_wall;
-    Vector2 wall_normal; // для стен
+    VecN<D> wall_normal; // для стен (гиперплоскость через position)
+    BasicObstacleTrajectory<D> trajectory;
+    
+    BasicObstacle(VecN<D> pos = VecN<D>(), double r = 15.0, bool wall = false)
+        : position(pos), velocity(), radius(r), is_wall(wall) {}
+};
+
+using Agent = BasicAgent<2>;
+using BetaAgent = BasicBetaAgent<2>;
+using ObstacleTrajectory = BasicObstacleTrajectory<2>;
+using Obstacle = BasicObstacle<2>;
+
+// Хеш-сетка препятствий: каждое препятствие записано в ячейки, которые
+// покрывает его окрестность радиуса r'. При движении обновляются только
+// ячейки, в которые препятствие вошло или из которых вышло. В 3D ячейки
+// - столбцы по проекции на плоскость x-y.
+class ObstacleGrid {
+public:
+    explicit ObstacleGrid(double cell_size = 32.0) : cell_size(cell_size) {}
+    
+    void clear();
+    void insert(int index, const Vector2& center, double extent);
+    void refit(int index, const Vector2& center, double extent);
+    
+    // Препятствия, окрестность которых может содержать точку
+    const std::vector<int>* query(const Vector2& point) const;
+
+private:
+    struct CellRange {
+        int min_x, min_y, max_x, max_y;
+        bool contains(int cx, int cy) const { return cx >= min_x && cx <= max_x && cy >= min_y && cy <= max_y; }
+        bool operator==(const CellRange& other) const {
+            return min_x == other.min_x && min_y == other.min_y && max_x == other.max_x && max_y == other.max_y;
+        }
+    };
+    
+    double cell_size;
+    std::vector<CellRange> ranges; // текущие ячейки каждого препятствия
+    std::unordered_map<long long, std::vector<int>> cells;
+    
+    int cell_coord(double v) const { return static_cast<int>(std::floor(v / cell_size)); }
+    static long long cell_id(int cx, int cy) {
+        return (static_cast<long long>(cx) << 32) ^ static_cast<unsigned int>(cy);
+    }
+    CellRange compute_range(const Vector2& center, double extent) const;
+    void add_to_cell(int index, int cx, int cy);
+    void remove_from_cell(int index, int cx, int cy);
+};
+
+// Равномерная сетка ячеек размера не меньше радиуса взаимодействия.
+// Ячейки сгруппированы в тайлы tile_span x tile_span по осям x и y
+// (в 3D тайл - столбец на всю высоту), агенты отсортированы по ключу
+// ячейки, поэтому агенты одного тайла лежат подряд.
+template <int D>
+struct BasicSpatialGrid {
+    VecN<D> origin;
+    double cell_size = 1.0;
+    int cols = 0, rows = 0, layers = 1; // число ячеек по x, y и z
+    int tile_span = 1;                  // ячеек в тайле по x и y
+    int tile_cols = 0, tile_rows = 0;   // число тайлов
+    std::vector<size_t> cell_start;     // агенты ячейки key: [cell_start[key], cell_start[key + 1])
+    
+    int tile_count() const { return tile_cols * tile_rows; }
+    int cells_per_tile() const { return tile_span * tile_span * layers; }
+    
+    int cell_x(double x) const { return std::min(cols - 1, std::max(0, static_cast<int>((x - origin[0]) / cell_size))); }
+    int cell_y(double y) const { return std::min(rows - 1, std::max(0, static_cast<int>((y - origin[1]) / cell_size))); }
+    int cell_z(const VecN<D>& p) const {
+        if constexpr (D == 3) {
+            return std::min(layers - 1, std::max(0, static_cast<int>((p.z - origin.z) / cell_size)));
+        } else {
+            return 0;
+        }
+    }
+    
+    int tile_of_cell(int cx, int cy) const { return (cy / tile_span) * tile_cols + (cx / tile_span); }
+    int cell_key(int cx, int cy, int cz = 0) const {
+        return tile_of_cell(cx, cy) * cells_per_tile() + (cz * tile_span + cy % tile_span) * tile_span + (cx % tile_span);
+    }
+    int cell_key(const VecN<D>& p) const { return cell_key(cell_x(p.x), cell_y(p.y), cell_z(p)); }
     
-    Obstacle(Vector2 pos = Vector2(0, 0), double r = 15.0, bool wall = false) 
-        : position(pos), radius(r), is_wall(wall) {}
+    size_t tile_begin(int tile) const { return cell_start[tile * cells_per_tile()]; }
+    size_t tile_end(int tile) const { return cell_start[(tile + 1) * cells_per_tile()]; }
 };
 
-// Основной класс симуляции
-class FlockSimulation {
+using SpatialGrid = BasicSpatialGrid<2>;
+
+// Наблюдатель шага: вызывается в конце step() под блокировкой данных
+template <int D>
+using BasicStepObserver = std::function<void(const std::vector<BasicAgent<D>>& agents, const VecN<D>& target,
+                                             bool target_enabled, double time)>;
+using StepObserver = BasicStepObserver<2>;
+
+// Параметры Algorithm 3 из статьи
+struct FlockParameters {
+    // Основные параметры
+    double desired_distance = 7; // d
+    double interaction_range = 8.4; // r = 1.2 * d
+    double obstacle_range = 5.2; // r' = 0.6 * r
+    
+    // Коэффициенты сил
+    double c1_alpha = 8.0; // для α-взаимодействий
+    double c2_alpha = 6.0; // демпфирование α
+    double c1_beta = 5.0;  // для β-взаимодействий
+    double c2_beta = 2.0;  // демпфирование β
+    double c1_gamma = 0.5; // для навигации
+    double c2_gamma = 0.8; // демпфирование навигации
+    
+    // Параметры σ-нормы
+    double epsilon = 0.1;
+    
+    // Параметры bump-функций
+    double h_alpha = 0.2;
+    double h_beta = 0.8;
+
+};
+
+// α-взаимодействие с агентами чужих групп
+enum class CrossGroupRule {
+    Flock,    // как со своими: притяжение, отталкивание и согласование скоростей
+    Separate, // только отталкивание ближе d (избегание столкновений)
+    Ignore    // чужие агенты не действуют
+};
+
+// Группа агентов (отряд) со своей целью и параметрами. Группа 0 создается
+// вместе с симуляцией из ее параметров и управляется set_target/remove_target.
+template <int D>
+struct BasicFlockGroup {
+    FlockParameters params;
+    VecN<D> target;
+    VecN<D> target_velocity; // γ-скорость: цель движется с этой скоростью
+    bool has_target = true;
+    CrossGroupRule cross_group = CrossGroupRule::Separate;
+};
+
+using FlockGroup = BasicFlockGroup<2>;
+
+// Конфигурация ядра сил, известная на этапе компиляции: выбирается один
+// раз на шаг, внутри цикла по агентам проверок режима нет
+template <bool Target, bool Obstacles, bool Metrics, bool Groups>
+struct StepPolicy {
+    static constexpr bool with_target = Target;
+    static constexpr bool with_obstacles = Obstacles;
+    static constexpr bool with_metrics = Metrics;
+    static constexpr bool with_groups = Groups;
+};
+
+// Основной класс симуляции. Размерность пространства - параметр шаблона;
+// реализация инстанцируется явно для 2D и 3D в simulation.cpp.
+template <int D>
+class BasicFlockSimulation {
+    static_assert(D == 2 || D == 3, "flocking is implemented for 2D and 3D");
+
+public:
+    using Vec = VecN<D>;
+    using AgentType = BasicAgent<D>;
+    using BetaAgentType = BasicBetaAgent<D>;
+    using ObstacleType = BasicObstacle<D>;
+    using Grid = BasicSpatialGrid<D>;
+    using Observer = BasicStepObserver<D>;
+    using Parameters = FlockParameters;
+    using GroupType = BasicFlockGroup<D>;
+    
+    static constexpr int dimension = D;
+
 private:
-    std::vector<Agent> agents;
-    std::vector<Obstacle> obstacles;
-    std::vector<BetaAgent> beta_agents; // β-агенты для препятствий
-    Vector2 gamma_target;
-    Vector2 gamma_velocity;
+    std::vector<AgentType> agents;
+    std::vector<ObstacleType> obstacles;
+    ObstacleGrid obstacle_grid;
+    double simulation_time = 0.0;
+    double world_bound = 200.0; // половина стороны области (мягкая граница - 0.9 от нее)
+    std::vector<BetaAgentType> beta_agents; // β-агенты для препятствий
+    std::vector<std::vector<BetaAgentType>> tile_beta_agents; // β-агенты по тайлам
     
     mutable std::mutex data_mutex; // mutable для const методов
+    
+    // Снимок агентов для рендеринга: заполняется задачами интегрирования,
+    // публикуется обменом буферов в конце шага
+    std::vector<AgentType> agents_snapshot;
+    std::vector<AgentType> snapshot_back;
+    mutable std::mutex snapshot_mutex;
+    
+    // Сетка, по которой упорядочен снимок: отбор видимых агентов без полного перебора
+    Grid snapshot_grid;
+    bool snapshot_grid_valid = false;
+    double snapshot_grid_margin = 0.0;
+    
+    // Пространственное разбиение и граф задач шага
+    Grid grid;
+    std::vector<AgentType> sorted_agents;
+    std::vector<int> agent_keys;
+    std::vector<size_t> cell_cursor;
+    
+    // Призрачные агенты (копии соседей из других доменов): участвуют
+    // в вычислении сил, но не интегрируются и удаляются после шага
+    std::vector<AgentType> ghost_agents;
+    std::vector<char> ghost_flags;  // по индексам agents во время шага
+    std::vector<char> sorted_flags;
+    TaskGraph step_graph;
+    TaskScheduler* scheduler;
+    double step_dt = 0.0;
+    bool publish_step = true; // копировать ли агентов в снимок на этом шаге
+    
+    // Граф шага зависит только от разбиения на тайлы и выбранного ядра сил:
+    // пока они те же, граф переиспользуется
+    using TileTask = void (BasicFlockSimulation::*)(int);
+    int graph_tile_cols = -1, graph_tile_rows = -1;
+    TileTask graph_kernel = nullptr;
+    
+    Observer step_observer;
     std::atomic<bool> running{false};
     
+    // Метрики: частичные суммы по тайлам и компоненты связности
+    // собираются задачами сил, сводятся в конце шага
+    MetricsConfig metrics_config;
+    std::vector<MetricsAccumulator> tile_metrics;
+    ConcurrentUnionFind components;
+    std::vector<uint32_t> component_sizes;
+    FlockMetrics latest_metrics;         // под snapshot_mutex
+    std::deque<FlockMetrics> metrics_history;
+    
     // Флаги управления
     bool show_beta_agents = false;
     bool use_gamma_target = true;
     bool show_connections = false; // НОВОЕ: отображение сетки связей
     
-    // Параметры Algorithm 3 из статьи
-    struct Parameters {
-        // Основные параметры
-        double desired_distance = 7; // d
-        double interaction_range = 8.4; // r = 1.2 * d
-        double obstacle_range = 5.2; // r' = 0.6 * r
-        
-        // Коэффициенты сил
-        double c1_alpha = 8.0; // для α-взаимодействий
-        double c2_alpha = 6.0; // демпфирование α
-        double c1_beta = 5.0;  // для β-взаимодействий  
-        double c2_beta = 2.0;  // демпфирование β
-        double c1_gamma = 0.5; // для навигации
-        double c2_gamma = 0.8; // демпфирование навигации
-        
-        // Параметры σ-нормы
-        double epsilon = 0.1;
-        
-        // Параметры bump-функций
-        double h_alpha = 0.2;
-        double h_beta = 0.8;
-        
-    } params;
+    Parameters params;
+    bool verbose = true; // сообщения о действиях пользователя в консоль
+    
+    // Константы ядра группы: настройки и σ-нормы радиусов, посчитанные
+    // один раз при изменении группы, а не в каждой паре
+    struct GroupKernel {
+        GroupType settings;
+        double r_alpha = 0.0;  // ||r||_σ
+        double d_alpha = 0.0;  // ||d||_σ
+        double d_beta = 0.0;   // ||d'||_σ
+        const double* potential = nullptr; // ψ_α на равномерной сетке z ∈ [0, r_α]
+        int potential_last = 0;
+        double potential_step = 0.0;
+    };
+    
+    // Таблица ψ_α для набора параметров; группы с одинаковыми α-параметрами делят ее
+    struct PotentialTable {
+        Parameters params;
+        std::vector<double> values;
+    };
+    
+    std::vector<GroupKernel> group_kernels;
+    std::vector<PotentialTable> potential_tables;
+    double max_interaction_range = 0.0; // по всем группам: размер ячейки сетки
+    double max_obstacle_range = 0.0;
 
 public:
-    FlockSimulation();
+    explicit BasicFlockSimulation(TaskScheduler* scheduler = &TaskScheduler::shared());
+    BasicFlockSimulation(const Parameters& parameters, size_t agent_count, unsigned seed,
+                         TaskScheduler* scheduler = &TaskScheduler::shared());
     
     void step(double delta_time);
-    void add_obstacle(const Vector2& position, double radius = 15.0);
-    void set_target(const Vector2& target);
+    
+    // count шагов под одной блокировкой: снимок публикуется только после
+    // последнего, метрики и наблюдатель по-прежнему видят каждый шаг
+    void step_n(size_t count, double delta_time);
+    
+    void add_obstacle(const Vec& position, double radius = 15.0);
+    void add_moving_obstacle(const Vec& position, const Vec& velocity, double radius = 15.0);
+    void add_orbiting_obstacle(const Vec& center, double orbit_radius, double angular_speed,
+                               double radius = 15.0, double phase = 0.0);
+    void set_obstacle_velocity(size_t index, const Vec& velocity);
+    void set_target(const Vec& target);
     void clear_obstacles();
     
+    // Граница области; по умолчанию растет с числом агентов при создании стаи
+    void set_world_bound(double bound);
+    double get_world_bound() const;
+    
+    // Группы агентов: своя цель, γ-скорость и параметры у каждой
+    uint32_t add_group(const GroupType& group);
+    void set_group(uint32_t group, const GroupType& settings);
+    void set_group_target(uint32_t group, const Vec& target, const Vec& velocity = Vec());
+    GroupType get_group(uint32_t group) const;
+    size_t get_group_count() const;
+    void assign_groups(const std::function<uint32_t(const AgentType&)>& classify);
+    void set_step_observer(Observer observer);
+    
+    // Обмен агентами с другими доменами (распределенный режим)
+    void set_ghost_agents(std::vector<AgentType> ghosts);
+    void add_agents(const std::vector<AgentType>& new_agents);
+    std::vector<AgentType> extract_agents(const std::function<bool(const AgentType&)>& predicate);
+    std::vector<AgentType> copy_agents(const std::function<bool(const AgentType&)>& predicate) const;
+    size_t get_agent_count() const;
+    
     // Методы для получения данных для рендеринга - теперь const
-    std::vector<Agent> get_agents() const;
-    std::vector<Obstacle> get_obstacles() const;
-    std::vector<BetaAgent> get_beta_agents() const;
-    Vector2 get_target() const;
+    std::vector<AgentType> get_agents() const;
+    std::vector<AgentType> get_agents_in_region(const Vec& min_corner, const Vec& max_corner) const;
+    std::vector<ObstacleType> get_obstacles() const;
+    std::vector<BetaAgentType> get_beta_agents() const;
+    Vec get_target() const;
+    
+    // Представления без копирования. Держат блокировку, пока живы:
+    // AgentsView задерживает публикацию снимка, StateView - и сам шаг,
+    // поэтому их стоит держать только на время чтения
+    struct AgentsView {
+        std::unique_lock<std::mutex> snapshot_lock;
+        Span<AgentType> agents;
+    };
+    
+    struct StateView {
+        std::unique_lock<std::mutex> data_lock;
+        std::unique_lock<std::mutex> snapshot_lock;
+        Span<AgentType> agents;
+        Span<ObstacleType> obstacles;
+        Span<BetaAgentType> beta_agents;
+        Vec target;
+        double interaction_range;
+        double obstacle_range;
+    };
     
-    // Геттеры параметров для рендеринга
-    double get_interaction_range() const { return params.interaction_range; }
-    double get_obstacle_range() const { return params.obstacle_range; }
+    AgentsView view_agents() const;
+    StateView view_state() const;
+    
+    // Геттеры параметров для рендеринга: радиусы - наибольшие по группам
+    double get_interaction_range() const;
+    double get_obstacle_range() const;
+    
+    // Метрики последнего шага и их временной ряд
+    void set_metrics_config(const MetricsConfig& config);
+    FlockMetrics get_metrics() const;
+    std::vector<FlockMetrics> get_metrics_history() const;
     
     // Новые методы управления - теперь const где необходимо
     void toggle_beta_display() { show_beta_agents = !show_beta_agents; }
@@ -139,29 +492,70 @@ public:
     bool is_running() const { return running; }
     void start() { running = true; }
     void stop() { running = false; }
+    void set_verbose(bool enabled) { verbose = enabled; }
 
 private:
     // Вспомогательные математические функции
-    double sigma_norm(const Vector2& z) const;
-    Vector2 sigma_epsilon(const Vector2& z) const;
-    double bump_function(double z, double h) const;
+    static double sigma_norm(const Vec& z, double epsilon);
+    static Vec sigma_epsilon(const Vec& z, double epsilon);
+    static double bump_function(double z, double h);
+    
+    // Функции действия (action functions) с константами группы
+    static double phi_alpha(double z, const GroupKernel& kernel);
+    static double phi_beta(double z, const GroupKernel& kernel);
+    
+    // Константы ядра группы и наибольшие радиусы по группам
+    void create_default_group();
+    GroupKernel make_group_kernel(const GroupType& settings);
+    void update_group_ranges();
+    
+    // Потенциал ψ_α(z) = ∫_{d_α}^{z} φ_α(s) ds по таблице
+    const PotentialTable& find_potential_table(const GroupKernel& kernel);
+    static double psi_alpha(double z, const GroupKernel& kernel);
+    
+    // Внутренние методы вычисления сил согласно Algorithm 3;
+    // WithMetrics - попутно собирать метрики по парам соседей,
+    // WithGroups - применять правила взаимодействия с чужими группами
+    template <bool WithMetrics, bool WithGroups>
+    Vec compute_alpha_force(const AgentType& agent, size_t index, const GroupKernel& kernel,
+                            MetricsAccumulator* metrics);
+    Vec compute_beta_force(const AgentType& agent, const GroupKernel& kernel);
+    Vec compute_gamma_force(const AgentType& agent, const GroupKernel& kernel);
     
-    // Вычисление матриц смежности
-    double alpha_adjacency(const Vector2& q_i, const Vector2& q_j) const;
-    double beta_adjacency(const Vector2& q_i, const Vector2& obstacle_pos) const;
+    // Случайная начальная расстановка; область растет с числом агентов
+    void spawn_agents(size_t count, unsigned seed);
     
-    // Функции действия (action functions)
-    double phi_alpha(double z) const;
-    double phi_beta(double z) const;
+    // Один шаг под уже взятой data_mutex; publish - публиковать ли снимок
+    void advance(double delta_time, bool publish);
     
-    // Внутренние методы вычисления сил согласно Algorithm 3
-    Vector2 compute_alpha_force(const Agent& agent);
-    Vector2 compute_beta_force(const Agent& agent);
-    Vector2 compute_gamma_force(const Agent& agent);
+    // Сортировка агентов по ячейкам сетки (внутри ячейки - по группам) и разбиение на тайлы
+    void build_spatial_grid();
+    void sort_cells_by_group();
+    void build_step_graph();
+    void remove_ghosts();
+    FlockMetrics reduce_metrics();
     
-    // Обновление β-агентов
-    void update_beta_agents();
+    // Движение препятствий и обновление их хеш-сетки
+    void move_obstacles(double delta_time);
+    
+    // Задачи шага для одного тайла (TileTask); ядро сил выбирается по режиму один раз на шаг
+    TileTask select_force_kernel() const;
+    template <size_t... Index>
+    static std::array<TileTask, sizeof...(Index)> make_force_kernels(std::index_sequence<Index...>);
+    
+    void update_beta_agents(int tile);
+    template <class Policy>
+    void compute_tile_forces(int tile);
+    void integrate_tile(int tile);
+    void integrate_agent(AgentType& agent, double delta_time) const;
     
     // Проекция на препятствия для создания β-агентов
-    BetaAgent project_to_obstacle(const Agent& agent, const Obstacle& obstacle) const;
-};
\ No newline at end of file
+    BetaAgentType project_to_obstacle(const AgentType& agent, const ObstacleType& obstacle) const;
+    void rebuild_obstacle_grid();
+};
+
+extern template class BasicFlockSimulation<2>;
+extern template class BasicFlockSimulation<3>;
+
+using FlockSimulation = BasicFlockSimulation<2>;
+using FlockSimulation3D = BasicFlockSimulation<3>;
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Непрерывный диапазон только для чтения (аналог std::span из C++20).
+// Не владеет данными: действителен, пока жив и не изменяется источник
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(const T* data, size_t size) : items(data), count(size) {}
+    Span(const std::vector<T>& vector) : items(vector.data()), count(vector.size()) {}
+
+    const T* data() const { return items; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    const T& operator[](size_t index) const { return items[index]; }
+
+private:
+    const T* items = nullptr;
+    size_t count = 0;
+};
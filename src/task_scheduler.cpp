@@ -0,0 +1,181 @@
+#include "task_scheduler.h"
+#include <algorithm>
+
+TaskGraph::TaskId TaskGraph::add_task(std::function<void()> fn) {
+    Task task;
+    task.fn = std::move(fn);
+    tasks.push_back(std::move(task));
+    return tasks.size() - 1;
+}
+
+void TaskGraph::add_dependency(TaskId before, TaskId after) {
+    tasks[before].successors.push_back(after);
+    tasks[after].dependencies++;
+}
+
+void TaskGraph::clear() {
+    tasks.clear();
+}
+
+TaskScheduler::TaskScheduler(unsigned thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < thread_count; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    // Поток 0 - вызывающий, остальные - рабочие
+    for (unsigned i = 1; i < thread_count; ++i) {
+        workers.emplace_back(&TaskScheduler::worker_loop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        shutting_down = true;
+    }
+    wake_cv.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+TaskScheduler& TaskScheduler::shared() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+void TaskScheduler::run_inline(TaskGraph& graph) {
+    // Алгоритм Кана: очередь готовых задач
+    std::vector<int> counts(graph.tasks.size());
+    std::vector<TaskGraph::TaskId> ready;
+
+    for (size_t i = 0; i < graph.tasks.size(); ++i) {
+        counts[i] = graph.tasks[i].dependencies;
+        if (counts[i] == 0) ready.push_back(i);
+    }
+
+    while (!ready.empty()) {
+        TaskGraph::TaskId id = ready.back();
+        ready.pop_back();
+
+        graph.tasks[id].fn();
+        for (TaskGraph::TaskId next : graph.tasks[id].successors) {
+            if (--counts[next] == 0) ready.push_back(next);
+        }
+    }
+}
+
+void TaskScheduler::run(TaskGraph& graph) {
+    if (graph.empty()) return;
+
+    if (workers.empty()) {
+        run_inline(graph);
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+
+    if (pending_capacity < graph.tasks.size()) {
+        pending_capacity = graph.tasks.size();
+        pending.reset(new std::atomic<int>[pending_capacity]);
+    }
+    for (size_t i = 0; i < graph.tasks.size(); ++i) {
+        pending[i].store(graph.tasks[i].dependencies, std::memory_order_relaxed);
+    }
+    remaining.store(graph.tasks.size());
+
+    // Корневые задачи раздаем по очередям по кругу
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        active_graph = &graph;
+
+        unsigned next_queue = 0;
+        for (size_t i = 0; i < graph.tasks.size(); ++i) {
+            if (graph.tasks[i].dependencies == 0) {
+                push(next_queue, i);
+                next_queue = (next_queue + 1) % queues.size();
+            }
+        }
+        generation++;
+    }
+    wake_cv.notify_all();
+
+    drain(0);
+
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    active_graph = nullptr;
+}
+
+void TaskScheduler::worker_loop(unsigned index) {
+    unsigned long seen_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake_cv.wait(lock, [&] { return shutting_down || generation != seen_generation; });
+            if (shutting_down) return;
+            seen_generation = generation;
+        }
+        drain(index);
+    }
+}
+
+void TaskScheduler::drain(unsigned index) {
+    TaskGraph::TaskId id;
+
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (pop_local(index, id) || steal(index, id)) {
+            execute(index, id);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool TaskScheduler::pop_local(unsigned index, TaskGraph::TaskId& id) {
+    WorkQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+
+    id = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool TaskScheduler::steal(unsigned index, TaskGraph::TaskId& id) {
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+
+        id = victim.tasks.front();
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::execute(unsigned index, TaskGraph::TaskId id) {
+    TaskGraph::Task& task = active_graph->tasks[id];
+    task.fn();
+
+    // Освобождаем последователей, ставших готовыми
+    for (TaskGraph::TaskId next : task.successors) {
+        if (pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            push(index, next);
+        }
+    }
+
+    remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void TaskScheduler::push(unsigned index, TaskGraph::TaskId id) {
+    WorkQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(id);
+}
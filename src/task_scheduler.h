@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+// Граф задач: узлы - функции, рёбра - зависимости "before -> after"
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    TaskId add_task(std::function<void()> fn);
+    void add_dependency(TaskId before, TaskId after);
+    void clear();
+
+    size_t size() const { return tasks.size(); }
+    bool empty() const { return tasks.empty(); }
+
+private:
+    friend class TaskScheduler;
+
+    struct Task {
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        int dependencies = 0; // число входящих рёбер
+    };
+
+    std::vector<Task> tasks;
+};
+
+// Планировщик с work-stealing очередями: у каждого потока своя очередь,
+// свои задачи берутся с конца (LIFO), чужие крадутся с начала (FIFO).
+// Вызывающий поток участвует в выполнении графа как поток с индексом 0.
+class TaskScheduler {
+public:
+    // thread_count - общее число потоков, включая вызывающий (0 - по числу ядер)
+    explicit TaskScheduler(unsigned thread_count = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Выполняет граф и возвращается, когда все задачи завершены.
+    // Вложенный run() из задачи не поддерживается.
+    void run(TaskGraph& graph);
+
+    unsigned get_thread_count() const { return static_cast<unsigned>(queues.size()); }
+
+    // Общий планировщик процесса
+    static TaskScheduler& shared();
+
+    // Последовательное выполнение графа в топологическом порядке
+    static void run_inline(TaskGraph& graph);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<TaskGraph::TaskId> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex run_mutex; // один граф за раз
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    unsigned long generation = 0;
+    bool shutting_down = false;
+
+    TaskGraph* active_graph = nullptr;
+    std::unique_ptr<std::atomic<int>[]> pending; // оставшиеся зависимости по задачам
+    size_t pending_capacity = 0;
+    std::atomic<size_t> remaining{0};
+
+    void worker_loop(unsigned index);
+    void drain(unsigned index);
+    bool pop_local(unsigned index, TaskGraph::TaskId& id);
+    bool steal(unsigned index, TaskGraph::TaskId& id);
+    void execute(unsigned index, TaskGraph::TaskId id);
+    void push(unsigned index, TaskGraph::TaskId id);
+};
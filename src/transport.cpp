@@ -0,0 +1,119 @@
+#include "transport.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+bool Transport::exchange(int peer, const void* data, size_t bytes, std::vector<char>& received) {
+    if (rank() < peer) {
+        return send(peer, data, bytes) && receive(peer, received);
+    }
+    return receive(peer, received) && send(peer, data, bytes);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+bool write_all(int fd, const char* data, size_t bytes) {
+    while (bytes > 0) {
+        ssize_t written = ::write(fd, data, bytes);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        bytes -= written;
+    }
+    return true;
+}
+
+bool read_all(int fd, char* data, size_t bytes) {
+    while (bytes > 0) {
+        ssize_t got = ::read(fd, data, bytes);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (got == 0) return false; // собеседник закрыл канал
+        data += got;
+        bytes -= got;
+    }
+    return true;
+}
+
+} // namespace
+
+bool UnixSocketTransport::create_mesh(int size, Mesh& mesh) {
+    mesh.size = size;
+    mesh.fds.assign(size * size, -1);
+
+    for (int i = 0; i < size; ++i) {
+        for (int j = i + 1; j < size; ++j) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                std::cerr << "Failed to create socket pair: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            mesh.fds[i * size + j] = pair[0];
+            mesh.fds[j * size + i] = pair[1];
+        }
+    }
+    return true;
+}
+
+UnixSocketTransport::UnixSocketTransport(int rank, const Mesh& mesh) : own_rank(rank), peers(mesh.size, -1) {
+    for (int i = 0; i < mesh.size; ++i) {
+        for (int j = 0; j < mesh.size; ++j) {
+            int fd = mesh.fds[i * mesh.size + j];
+            if (fd < 0) continue;
+
+            if (i == rank) {
+                peers[j] = fd;
+            } else {
+                ::close(fd);
+            }
+        }
+    }
+}
+
+UnixSocketTransport::~UnixSocketTransport() {
+    for (int fd : peers) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+bool UnixSocketTransport::send(int peer, const void* data, size_t bytes) {
+    // Сообщение: длина (8 байт), затем данные
+    uint64_t length = bytes;
+    return write_all(peers[peer], reinterpret_cast<const char*>(&length), sizeof(length)) &&
+           write_all(peers[peer], static_cast<const char*>(data), bytes);
+}
+
+bool UnixSocketTransport::receive(int peer, std::vector<char>& data) {
+    uint64_t length = 0;
+    if (!read_all(peers[peer], reinterpret_cast<char*>(&length), sizeof(length))) return false;
+
+    data.resize(length);
+    return read_all(peers[peer], data.data(), length);
+}
+
+#else
+
+bool UnixSocketTransport::create_mesh(int, Mesh&) {
+    std::cerr << "Unix socket transport is not supported on Windows" << std::endl;
+    return false;
+}
+
+UnixSocketTransport::UnixSocketTransport(int rank, const Mesh& mesh) : own_rank(rank), peers(mesh.size, -1) {}
+UnixSocketTransport::~UnixSocketTransport() {}
+bool UnixSocketTransport::send(int, const void*, size_t) { return false; }
+bool UnixSocketTransport::receive(int, std::vector<char>&) { return false; }
+
+#endif
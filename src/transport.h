@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstring>
+
+// Транспорт сообщений между процессами-доменами. Сообщения упорядочены
+// и не теряются в пределах пары процессов.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    virtual bool send(int peer, const void* data, size_t bytes) = 0;
+    virtual bool receive(int peer, std::vector<char>& data) = 0; // блокирующий
+
+    // Двусторонний обмен без взаимной блокировки: младший ранг сначала
+    // отправляет, старший сначала принимает
+    bool exchange(int peer, const void* data, size_t bytes, std::vector<char>& received);
+
+    template <typename T>
+    bool exchange_vector(int peer, const std::vector<T>& out, std::vector<T>& in) {
+        std::vector<char> buffer;
+        if (!exchange(peer, out.data(), out.size() * sizeof(T), buffer)) return false;
+        in.resize(buffer.size() / sizeof(T));
+        if (!buffer.empty()) std::memcpy(in.data(), buffer.data(), in.size() * sizeof(T));
+        return true;
+    }
+};
+
+// Транспорт поверх пар Unix-сокетов для процессов одной машины.
+// Полная сетка socketpair создается до fork(), каждый процесс
+// оставляет себе только свои концы.
+class UnixSocketTransport : public Transport {
+public:
+    struct Mesh {
+        int size = 0;
+        std::vector<int> fds; // fds[i * size + j] - конец процесса i в канале i <-> j
+    };
+
+    static bool create_mesh(int size, Mesh& mesh);
+
+    // Вызывается в процессе rank после fork(): закрывает чужие концы
+    UnixSocketTransport(int rank, const Mesh& mesh);
+    ~UnixSocketTransport() override;
+
+    int rank() const override { return own_rank; }
+    int size() const override { return static_cast<int>(peers.size()); }
+
+    bool send(int peer, const void* data, size_t bytes) override;
+    bool receive(int peer, std::vector<char>& data) override;
+
+private:
+    int own_rank;
+    std::vector<int> peers; // fd канала к каждому процессу (-1 для себя)
+};
@@ -0,0 +1,109 @@
+// Компоненты связности: параллельная система непересекающихся множеств
+// и метрики шага против обхода графа близости перебором всех пар
+#include "simulation.h"
+#include "test_support.h"
+#include <numeric>
+#include <thread>
+
+namespace {
+
+// Последовательная система множеств для эталона
+struct SerialUnionFind {
+    std::vector<uint32_t> parent;
+    explicit SerialUnionFind(size_t count) : parent(count) { std::iota(parent.begin(), parent.end(), 0u); }
+    uint32_t find(uint32_t x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    }
+    void unite(uint32_t a, uint32_t b) { parent[find(a)] = find(b); }
+};
+
+void check_concurrent_union_find() {
+    const size_t count = 20000;
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<uint32_t> pick(0, count - 1);
+    std::vector<std::pair<uint32_t, uint32_t>> edges(15000);
+    for (auto& edge : edges) edge = {pick(gen), pick(gen)};
+
+    ConcurrentUnionFind components;
+    components.reset(count);
+    const int threads = 4;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t e = t; e < edges.size(); e += threads) components.unite(edges[e].first, edges[e].second);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    SerialUnionFind reference(count);
+    for (const auto& edge : edges) reference.unite(edge.first, edge.second);
+
+    // Разбиения совпадают: одинаковый корень у эталона - одинаковый и у проверяемой
+    size_t mismatched = 0;
+    for (uint32_t x = 0; x < count; ++x) {
+        for (uint32_t y : {uint32_t(0), uint32_t(x / 2), pick(gen)}) {
+            bool same = components.find(x) == components.find(y);
+            if (same != (reference.find(x) == reference.find(y))) mismatched++;
+        }
+    }
+    CHECK(mismatched == 0);
+
+    // Корень - наименьший индекс компоненты
+    for (uint32_t x = 0; x < count; ++x) {
+        if (components.find(x) > x) mismatched++;
+    }
+    CHECK(mismatched == 0);
+}
+
+void check_step_metrics(unsigned threads) {
+    TaskScheduler scheduler(threads);
+    FlockParameters params;
+    FlockSimulation simulation(params, 1500, 3, &scheduler);
+    simulation.set_verbose(false);
+    MetricsConfig config;
+    config.enabled = true;
+    simulation.set_metrics_config(config);
+    simulation.step_n(50, 0.02);
+
+    for (int step = 0; step < 5; ++step) {
+        // Метрики шага описывают состояние в его начале
+        std::vector<Agent> agents = simulation.get_agents();
+        simulation.step(0.02);
+        FlockMetrics metrics = simulation.get_metrics();
+
+        SerialUnionFind reference(agents.size());
+        size_t edges = 0;
+        for (size_t i = 0; i < agents.size(); ++i) {
+            for (size_t j = i + 1; j < agents.size(); ++j) {
+                if ((agents[j].position - agents[i].position).length() < params.interaction_range) {
+                    reference.unite(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+                    edges++;
+                }
+            }
+        }
+        std::vector<size_t> sizes(agents.size(), 0);
+        for (uint32_t i = 0; i < agents.size(); ++i) sizes[reference.find(i)]++;
+        size_t components = 0, largest = 0;
+        for (size_t size : sizes) {
+            if (size > 0) components++;
+            largest = std::max(largest, size);
+        }
+
+        // Стая частично фрагментирована: проверка не вырождена
+        CHECK(components > 1 && largest > 1);
+        CHECK(metrics.agent_count == agents.size());
+        CHECK(metrics.components == components);
+        CHECK(metrics.largest_component == largest);
+        CHECK(test::near(metrics.mean_degree, 2.0 * edges / agents.size(), 1e-12));
+    }
+}
+
+} // namespace
+
+int main() {
+    check_concurrent_union_find();
+    check_step_metrics(1);
+    check_step_metrics(4);
+    return test::finish("test_components");
+}
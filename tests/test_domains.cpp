@@ -0,0 +1,167 @@
+// Два домена на транспорте в памяти против одного процесса: призраки гало
+// дают те же силы, что и полная стая, а миграция сохраняет всех агентов
+#include "domain.h"
+#include "test_support.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+// Очереди сообщений между потоками вместо сокетов
+struct Mailbox {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<std::deque<std::vector<char>>> queues; // queues[from * size + to]
+    int size;
+
+    explicit Mailbox(int size) : queues(size * size), size(size) {}
+};
+
+class MemoryTransport : public Transport {
+public:
+    MemoryTransport(Mailbox& mailbox, int rank) : mailbox(mailbox), own_rank(rank) {}
+
+    int rank() const override { return own_rank; }
+    int size() const override { return mailbox.size; }
+
+    bool send(int peer, const void* data, size_t bytes) override {
+        const char* begin = static_cast<const char*>(data);
+        std::lock_guard<std::mutex> lock(mailbox.mutex);
+        mailbox.queues[own_rank * mailbox.size + peer].emplace_back(begin, begin + bytes);
+        mailbox.ready.notify_all();
+        return true;
+    }
+
+    bool receive(int peer, std::vector<char>& data) override {
+        std::unique_lock<std::mutex> lock(mailbox.mutex);
+        auto& queue = mailbox.queues[peer * mailbox.size + own_rank];
+        mailbox.ready.wait(lock, [&] { return !queue.empty(); });
+        data = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+private:
+    Mailbox& mailbox;
+    int own_rank;
+};
+
+std::unique_ptr<FlockSimulation> make_simulation(const std::vector<Agent>& agents, double world_bound,
+                                                 TaskScheduler& scheduler) {
+    FlockParameters params;
+    auto simulation = std::make_unique<FlockSimulation>(params, 0, 1, &scheduler);
+    simulation->set_verbose(false);
+    simulation->set_world_bound(world_bound);
+    simulation->set_target(Vector2(0, 0));
+    simulation->add_agents(agents);
+    return simulation;
+}
+
+} // namespace
+
+int main() {
+    const double dt = 0.02;
+    std::vector<Agent> all_agents;
+    double world_bound = 0.0;
+    {
+        TaskScheduler serial(1);
+        FlockSimulation generator(FlockParameters(), 1200, 9, &serial);
+        all_agents = generator.get_agents();
+        world_bound = generator.get_world_bound();
+    }
+
+    std::vector<double> xs;
+    for (const auto& agent : all_agents) xs.push_back(agent.position.x);
+    std::nth_element(xs.begin(), xs.begin() + xs.size() / 2, xs.end());
+    double boundary = xs[xs.size() / 2];
+
+    std::vector<Agent> halves[2];
+    for (const auto& agent : all_agents) halves[agent.position.x < boundary ? 0 : 1].push_back(agent);
+
+    TaskScheduler single_scheduler(1);
+    auto single = make_simulation(all_agents, world_bound, single_scheduler);
+
+    Mailbox mailbox(2);
+    TaskScheduler schedulers[2] = {TaskScheduler(1), TaskScheduler(1)};
+    MemoryTransport transports[2] = {MemoryTransport(mailbox, 0), MemoryTransport(mailbox, 1)};
+    std::unique_ptr<FlockSimulation> domains[2];
+    std::unique_ptr<DomainNode> nodes[2];
+    double inf = std::numeric_limits<double>::infinity();
+    for (int rank = 0; rank < 2; ++rank) {
+        domains[rank] = make_simulation(halves[rank], world_bound, schedulers[rank]);
+        nodes[rank] = std::make_unique<DomainNode>(transports[rank], *domains[rank],
+                                                   rank == 0 ? -inf : boundary, rank == 0 ? boundary : inf);
+    }
+
+    auto run_domains = [&](int steps) {
+        bool ok[2] = {true, true};
+        std::vector<std::thread> workers;
+        for (int rank = 0; rank < 2; ++rank) {
+            workers.emplace_back([&, rank] {
+                for (int step = 0; step < steps && ok[rank]; ++step) ok[rank] = nodes[rank]->step(dt);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        CHECK(ok[0] && ok[1]);
+    };
+
+    // Живые агенты домена: опубликованный снимок не учитывает миграцию после шага
+    auto all = [](const Agent&) { return true; };
+    auto gather = [&] {
+        std::vector<Agent> agents = domains[0]->copy_agents(all);
+        std::vector<Agent> right = domains[1]->copy_agents(all);
+        agents.insert(agents.end(), right.begin(), right.end());
+        return agents;
+    };
+
+    // Короткий прогон: траектории совпадают до ошибок округления
+    // (порядок суммирования соседей в доменах другой)
+    const int short_steps = 5;
+    run_domains(short_steps);
+    single->step_n(short_steps, dt);
+
+    std::vector<Agent> distributed = gather();
+    std::vector<Agent> reference = single->get_agents();
+    CHECK(distributed.size() == reference.size());
+
+    std::unordered_map<uint32_t, Agent> by_id;
+    for (const auto& agent : reference) by_id[agent.id] = agent;
+    size_t mismatched = 0;
+    for (const auto& agent : distributed) {
+        auto it = by_id.find(agent.id);
+        if (it == by_id.end() || (agent.position - it->second.position).length() > 1e-6 ||
+            (agent.velocity - it->second.velocity).length() > 1e-6) {
+            mismatched++;
+        }
+    }
+    CHECK(mismatched == 0);
+
+    // Долгий прогон с миграцией и перебалансировкой: каждый агент ровно в одном домене
+    run_domains(300);
+    distributed = gather();
+    CHECK(distributed.size() == all_agents.size());
+
+    std::set<uint32_t> ids;
+    for (const auto& agent : distributed) ids.insert(agent.id);
+    CHECK(ids.size() == all_agents.size());
+    CHECK(!ids.empty() && *ids.begin() == 0 && *ids.rbegin() == all_agents.size() - 1);
+
+    // Миграция действительно была: часть агентов сменила домен
+    std::set<uint32_t> started_left;
+    for (const auto& agent : halves[0]) started_left.insert(agent.id);
+    size_t moved = 0;
+    for (const auto& agent : domains[1]->copy_agents(all)) moved += started_left.count(agent.id);
+    CHECK(moved > 0);
+
+    // Агенты лежат в полосах своих доменов (после миграции шага)
+    for (const auto& agent : domains[0]->copy_agents(all)) CHECK(agent.position.x < nodes[0]->get_upper());
+    for (const auto& agent : domains[1]->copy_agents(all)) CHECK(agent.position.x >= nodes[1]->get_lower());
+
+    return test::finish("test_domains");
+}
@@ -0,0 +1,92 @@
+// Экспорт в разделяемую память: кадр читается без искажений, вытесненные
+// кадры не выдаются, чужая версия формата отвергается
+#include "shm_exporter.h"
+#include "test_support.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+std::vector<Agent> make_agents(size_t count, double shift) {
+    std::vector<Agent> agents;
+    for (size_t i = 0; i < count; ++i) {
+        Agent agent(Vector2(i + shift, -0.5 * i), 0, static_cast<uint32_t>(count - i));
+        agent.velocity = Vector2(shift, i * 0.25);
+        agents.push_back(agent);
+    }
+    return agents;
+}
+
+// Меняет версию в заголовке уже созданного сегмента
+void overwrite_version(const std::string& name, uint32_t version) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    void* mapped = mmap(nullptr, sizeof(ShmHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    CHECK(mapped != MAP_FAILED);
+    if (mapped == MAP_FAILED) return;
+    static_cast<ShmHeader*>(mapped)->version = version;
+    munmap(mapped, sizeof(ShmHeader));
+}
+
+} // namespace
+
+int main() {
+    std::string name = "/flocking_test_" + std::to_string(getpid());
+    const uint32_t capacity = 64, slots = 3;
+
+    ShmExporter exporter;
+    CHECK(exporter.open(name, capacity, slots));
+
+    ShmReader reader;
+    CHECK(reader.open(name));
+    CHECK(reader.get_agent_capacity() == capacity);
+    CHECK(reader.get_slot_count() == slots);
+    CHECK(reader.latest_frame() == 0);
+
+    // Кадров больше, чем слотов: старые вытесняются
+    const int frames = 5;
+    for (int frame = 0; frame < frames; ++frame) {
+        exporter.publish(make_agents(40 + frame, frame), Vector2(frame, 2 * frame), frame % 2 == 0, 0.5 * frame);
+    }
+    CHECK(reader.latest_frame() == frames);
+
+    ShmFrameView view;
+    CHECK(!reader.acquire(0, view));
+    CHECK(reader.acquire_latest(view));
+    CHECK(reader.validate(view));
+
+    int last = frames - 1;
+    std::vector<Agent> expected = make_agents(40 + last, last);
+    CHECK(view.frame == static_cast<uint64_t>(last));
+    CHECK(view.time == 0.5 * last);
+    CHECK(view.target_enabled == (last % 2 == 0));
+    CHECK(view.target.x == last && view.target.y == 2 * last);
+    CHECK(view.agent_count == expected.size());
+    for (uint32_t i = 0; i < view.agent_count && i < expected.size(); ++i) {
+        CHECK(view.pos_x[i] == expected[i].position.x && view.pos_y[i] == expected[i].position.y);
+        CHECK(view.vel_x[i] == expected[i].velocity.x && view.vel_y[i] == expected[i].velocity.y);
+        CHECK(view.id[i] == expected[i].id);
+    }
+
+    // Агенты сверх емкости отбрасываются
+    exporter.publish(make_agents(capacity + 10, 0), Vector2(), false, 0);
+    CHECK(reader.acquire_latest(view) && view.agent_count == capacity);
+    reader.close();
+
+    // Читатель другой версии формата не подключается
+    overwrite_version(name, SHM_VERSION + 1);
+    ShmReader stale;
+    CHECK(!stale.open(name));
+    overwrite_version(name, SHM_VERSION);
+    CHECK(stale.open(name));
+    stale.close();
+
+    exporter.close();
+    ShmReader after_close;
+    CHECK(!after_close.open(name));
+
+    return test::finish("test_shm");
+}
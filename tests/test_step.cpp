@@ -0,0 +1,163 @@
+// Тайловый шаг против прямого перебора всех пар по формулам статьи
+// (уравнения (67)-(70)): позиции и скорости после каждого шага совпадают
+// до ошибок округления при любом числе потоков
+#include "simulation.h"
+#include "test_support.h"
+#include <unordered_map>
+
+namespace {
+
+const double MAX_SPEED = 100.0;
+
+struct Reference {
+    FlockParameters params;
+    Vector2 target;
+    std::vector<Obstacle> obstacles;
+    double world_bound = 200.0;
+
+    double sigma_norm(const Vector2& z) const {
+        return (std::sqrt(1.0 + params.epsilon * z.dot(z)) - 1.0) / params.epsilon;
+    }
+
+    Vector2 sigma_epsilon(const Vector2& z) const {
+        double norm = z.length();
+        return norm < 1e-10 ? Vector2() : z * (1.0 / std::sqrt(1.0 + params.epsilon * norm * norm));
+    }
+
+    static double bump(double z, double h) {
+        if (z < h) return 1.0;
+        if (z < 1.0) return 0.5 * (1.0 + std::cos(M_PI * (z - h) / (1.0 - h)));
+        return 0.0;
+    }
+
+    static double sigma_1(double s) { return s / std::sqrt(1.0 + s * s); }
+
+    // Один шаг: силы по состоянию начала шага, затем интегрирование
+    std::vector<Agent> step(const std::vector<Agent>& agents, double dt) const {
+        double r_alpha = sigma_norm(Vector2(params.interaction_range, 0));
+        double d_alpha = sigma_norm(Vector2(params.desired_distance, 0));
+        double d_beta = sigma_norm(Vector2(params.desired_distance * 0.6, 0));
+
+        std::vector<BetaAgent> betas;
+        for (const auto& agent : agents) {
+            for (const auto& obstacle : obstacles) {
+                Vector2 to_center = obstacle.position - agent.position;
+                if (to_center.length() >= params.obstacle_range + obstacle.radius) continue;
+                Vector2 direction = to_center.normalized();
+                BetaAgent beta;
+                beta.position = obstacle.position - direction * obstacle.radius;
+                double mu = obstacle.radius / to_center.length();
+                beta.velocity = (agent.velocity - direction * agent.velocity.dot(direction)) * mu;
+                betas.push_back(beta);
+            }
+        }
+
+        std::vector<Agent> next = agents;
+        for (size_t i = 0; i < agents.size(); ++i) {
+            const Agent& agent = agents[i];
+            Vector2 gradient, consensus, repulsion, damping;
+
+            for (size_t j = 0; j < agents.size(); ++j) {
+                if (j == i) continue;
+                Vector2 diff = agents[j].position - agent.position;
+                double distance = diff.length();
+                if (distance >= params.interaction_range || distance <= 0.1) continue;
+                double z = sigma_norm(diff);
+                double a_ij = bump(z / r_alpha, params.h_alpha);
+                gradient = gradient + sigma_epsilon(diff) * (a_ij * sigma_1(z - d_alpha));
+                consensus = consensus + (agents[j].velocity - agent.velocity) * a_ij;
+            }
+
+            for (const auto& beta : betas) {
+                Vector2 diff = beta.position - agent.position;
+                double distance = diff.length();
+                if (distance >= params.obstacle_range || distance <= 0.1) continue;
+                double z = sigma_norm(diff);
+                double b_ik = bump(z / d_beta, params.h_beta);
+                repulsion = repulsion + sigma_epsilon(diff) * (b_ik * (sigma_1(z - d_beta) - 1.0));
+                damping = damping + (beta.velocity - agent.velocity) * b_ik;
+            }
+
+            Vector2 offset = agent.position - target;
+            Vector2 gamma = offset * (-params.c1_gamma / std::sqrt(1.0 + offset.dot(offset))) -
+                            agent.velocity * params.c2_gamma;
+
+            Vector2 force = gradient * params.c1_alpha + consensus * params.c2_alpha +
+                            repulsion * params.c1_beta + damping * params.c2_beta + gamma;
+
+            Agent& out = next[i];
+            out.velocity = agent.velocity + force * dt;
+            if (out.velocity.length() > MAX_SPEED) out.velocity = out.velocity.normalized() * MAX_SPEED;
+            out.position = agent.position + out.velocity * dt;
+
+            double soft = 0.9 * world_bound;
+            for (int axis = 0; axis < 2; ++axis) {
+                double coordinate = std::abs(out.position[axis]);
+                if (coordinate <= soft) continue;
+                double push = coordinate < world_bound ? (world_bound - coordinate) / (world_bound - soft) : 1.0;
+                out.velocity[axis] += (out.position[axis] > 0 ? -1 : 1) * push * 5.0;
+            }
+        }
+        return next;
+    }
+};
+
+void run(unsigned threads, bool with_obstacles) {
+    TaskScheduler scheduler(threads);
+    FlockParameters params;
+    FlockSimulation simulation(params, 600, 11, &scheduler);
+    simulation.set_verbose(false);
+
+    Reference reference;
+    reference.params = params;
+    reference.target = Vector2(20, -10);
+    reference.world_bound = simulation.get_world_bound();
+    simulation.set_target(reference.target);
+    if (with_obstacles) {
+        simulation.add_obstacle(Vector2(0, 0), 20.0);
+        simulation.add_obstacle(Vector2(-60, 40), 12.0);
+        reference.obstacles = simulation.get_obstacles();
+    }
+
+    // Стая сначала сближается, чтобы пар соседей было много
+    simulation.step_n(100, 0.02);
+
+    for (int step = 0; step < 10; ++step) {
+        std::vector<Agent> before = simulation.get_agents();
+        std::vector<Agent> expected = reference.step(before, 0.02);
+        simulation.step(0.02);
+
+        std::unordered_map<uint32_t, const Agent*> by_id;
+        for (const auto& agent : expected) by_id[agent.id] = &agent;
+
+        std::vector<Agent> actual = simulation.get_agents();
+        CHECK(actual.size() == expected.size());
+        size_t mismatched = 0;
+        for (const auto& agent : actual) {
+            auto it = by_id.find(agent.id);
+            if (it == by_id.end()) { mismatched++; continue; }
+            const Agent& want = *it->second;
+            for (int axis = 0; axis < 2; ++axis) {
+                if (!test::near(agent.position[axis], want.position[axis], 1e-9) ||
+                    !test::near(agent.velocity[axis], want.velocity[axis], 1e-9)) {
+                    mismatched++;
+                    break;
+                }
+            }
+        }
+        CHECK(mismatched == 0);
+    }
+
+    // С препятствиями часть агентов действительно взаимодействует с ними
+    if (with_obstacles) CHECK(!simulation.get_beta_agents().empty());
+}
+
+} // namespace
+
+int main() {
+    run(1, false);
+    run(4, false);
+    run(1, true);
+    run(4, true);
+    return test::finish("test_step");
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+
+// Минимальные проверки для тестов ctest: ошибки печатаются, код возврата
+// main - число проваленных проверок
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool condition, const char* expression, const char* file, int line) {
+    if (condition) return;
+    failures()++;
+    std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+}
+
+inline bool near(double a, double b, double tolerance) {
+    return std::abs(a - b) <= tolerance * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+inline int finish(const char* name) {
+    if (failures() == 0) std::cout << name << ": OK" << std::endl;
+    else std::cerr << name << ": " << failures() << " check(s) failed" << std::endl;
+    return failures() == 0 ? 0 : 1;
+}
+
+} // namespace test
+
+#define CHECK(condition) ::test::check((condition), #condition, __FILE__, __LINE__)